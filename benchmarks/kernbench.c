@@ -0,0 +1,546 @@
+/*
+ * kernbench.c for libdivsufsort
+ * Copyright (c) 2003-2008 Yuta Mori All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* This program is built together with the library sources and
+   SA_TEST_HOOKS, which expose the sort kernels and count their key
+   comparisons. */
+#include "divsufsort_private.h"
+#include <time.h>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+
+
+#define MAXLIST (16)
+
+/* The settings of one measurement. */
+typedef struct {
+  saidx_t n; /* the group size */
+  saidx_t depth; /* the common prefix (ss) or rank distance (tr) */
+  double ties; /* the share of elements tied with another one */
+  saidx_t length; /* the substring length of the ss kernels */
+  saint_t sigma;
+  saidx_t threshold;
+} config_t;
+
+/* A kernel run: set up untimed, then timed on a fresh copy each rep. */
+typedef struct {
+  const char *name;
+  void *(*setup)(const config_t *cfg);
+  void (*reset)(void *state);
+  void (*run)(void *state);
+  void (*release)(void *state);
+} kernel_t;
+
+
+/*- Inputs -*/
+
+static unsigned int rng_state = 2463534242U;
+
+static
+unsigned int
+rng_next(void) {
+  rng_state ^= rng_state << 13, rng_state ^= rng_state >> 17, rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+/* Returns a uniform value in [0, n). */
+static
+saidx_t
+rng_below(saidx_t n) {
+  return (saidx_t)(((double)(rng_next() >> 1) / 2147483648.0) * (double)n);
+}
+
+static
+int
+rng_chance(double p) {
+  return ((double)(rng_next() >> 1) / 2147483648.0) < p;
+}
+
+static
+void
+shuffle(saidx_t *A, saidx_t n) {
+  saidx_t i, j, t;
+  for(i = n - 1; 0 < i; --i) { j = rng_below(i + 1); SWAP(A[i], A[j]); }
+}
+
+static
+saidx_t
+isqrt(saidx_t x) {
+  saidx_t r = 0;
+  while(((r + 1) * (r + 1)) <= x) { ++r; }
+  return r;
+}
+
+
+/*- ss kernels -*/
+
+/* Group element i stands for the substring T[i * length, (i + 1) * length + 2)
+   (PA[i] = i * length), whose first depth characters are shared by all. */
+typedef struct {
+  config_t cfg;
+  sauchar_t *T;
+  saidx_t *PA, *SA, *SA0, *buf;
+  saidx_t middle;
+} ss_state_t;
+
+static
+void
+ss_release(void *state) {
+  ss_state_t *s = (ss_state_t *)state;
+  if(s == NULL) { return; }
+  free(s->buf), free(s->SA0), free(s->SA), free(s->PA), free(s->T);
+  free(s);
+}
+
+static
+void *
+ss_setup(const config_t *cfg) {
+  ss_state_t *s = (ss_state_t *)calloc(1, sizeof(ss_state_t));
+  saidx_t n = cfg->n, L = cfg->length, i, j;
+
+  if(s == NULL) { return NULL; }
+  s->cfg = *cfg;
+  s->T = (sauchar_t *)malloc((size_t)(n + 2) * (size_t)L + 8);
+  s->PA = (saidx_t *)malloc((size_t)(n + 1) * sizeof(saidx_t));
+  s->SA = (saidx_t *)malloc((size_t)n * sizeof(saidx_t));
+  s->SA0 = (saidx_t *)malloc((size_t)n * sizeof(saidx_t));
+  s->buf = (saidx_t *)malloc((size_t)(n / 2 + 1) * sizeof(saidx_t));
+  if((s->T == NULL) || (s->PA == NULL) || (s->SA == NULL) ||
+     (s->SA0 == NULL) || (s->buf == NULL)) { ss_release(s); return NULL; }
+
+  for(i = 0; i <= (n + 1); ++i) {
+    memset(s->T + i * L, 'a', (size_t)cfg->depth);
+    if((0 < i) && (i < n) && rng_chance(cfg->ties)) {
+      j = rng_below(i);
+      memcpy(s->T + i * L + cfg->depth, s->T + j * L + cfg->depth, (size_t)(L - cfg->depth));
+    } else {
+      for(j = cfg->depth; j < L; ++j) { s->T[i * L + j] = (sauchar_t)('a' + rng_below(cfg->sigma)); }
+    }
+  }
+  for(i = 0; i <= n; ++i) { s->PA[i] = i * L; }
+  for(i = 0; i < n; ++i) { s->SA0[i] = i; }
+  shuffle(s->SA0, n);
+  return s;
+}
+
+static
+void
+ss_reset(void *state) {
+  ss_state_t *s = (ss_state_t *)state;
+  memcpy(s->SA, s->SA0, (size_t)s->cfg.n * sizeof(saidx_t));
+}
+
+/* Sorts both runs of the group in SA0, untimed, for the merges. */
+static
+void *
+ss_setup_runs(const config_t *cfg, saidx_t middle) {
+  ss_state_t *s = (ss_state_t *)ss_setup(cfg);
+  if(s == NULL) { return NULL; }
+  s->middle = middle;
+  ss_test_mintrosort(s->T, s->PA, s->SA0, s->SA0 + middle, cfg->depth, cfg->threshold);
+  ss_test_mintrosort(s->T, s->PA, s->SA0 + middle, s->SA0 + cfg->n, cfg->depth, cfg->threshold);
+  return s;
+}
+
+static
+void
+ss_run_mintrosort(void *state) {
+  ss_state_t *s = (ss_state_t *)state;
+  ss_test_mintrosort(s->T, s->PA, s->SA, s->SA + s->cfg.n, s->cfg.depth, s->cfg.threshold);
+}
+
+/* Merges two halves with a buffer of half the group. */
+static
+void *
+ss_setup_swapmerge(const config_t *cfg) {
+  return ss_setup_runs(cfg, cfg->n / 2);
+}
+
+static
+void
+ss_run_swapmerge(void *state) {
+  ss_state_t *s = (ss_state_t *)state;
+  ss_test_swapmerge(s->T, s->PA, s->SA, s->SA + s->middle, s->SA + s->cfg.n,
+                    s->buf, s->cfg.n / 2, s->cfg.depth);
+}
+
+/* Merges a tail of sqrt(n) elements in place, as sssort does. */
+static
+void *
+ss_setup_inplacemerge(const config_t *cfg) {
+  return ss_setup_runs(cfg, cfg->n - MAX(isqrt(cfg->n), 1));
+}
+
+static
+void
+ss_run_inplacemerge(void *state) {
+  ss_state_t *s = (ss_state_t *)state;
+  ss_test_inplacemerge(s->T, s->PA, s->SA, s->SA + s->middle, s->SA + s->cfg.n, s->cfg.depth);
+}
+
+
+/*- tr kernels -*/
+
+typedef struct {
+  config_t cfg;
+  saidx_t *ISA, *ISA0, *SA, *SA0;
+  saidx_t N; /* the size of ISA */
+  saidx_t a, b; /* the middle partition of tr_copy */
+} tr_state_t;
+
+static
+void
+tr_reset(void *state) {
+  tr_state_t *s = (tr_state_t *)state;
+  memcpy(s->ISA, s->ISA0, (size_t)s->N * sizeof(saidx_t));
+  memcpy(s->SA, s->SA0, (size_t)s->cfg.n * sizeof(saidx_t));
+}
+
+static
+void
+tr_release(void *state) {
+  tr_state_t *s = (tr_state_t *)state;
+  if(s == NULL) { return; }
+  free(s->SA0), free(s->SA), free(s->ISA0), free(s->ISA);
+  free(s);
+}
+
+static
+tr_state_t *
+tr_alloc(const config_t *cfg, saidx_t N) {
+  tr_state_t *s = (tr_state_t *)calloc(1, sizeof(tr_state_t));
+  if(s == NULL) { return NULL; }
+  s->cfg = *cfg, s->N = N;
+  s->ISA = (saidx_t *)malloc((size_t)N * sizeof(saidx_t));
+  s->ISA0 = (saidx_t *)malloc((size_t)N * sizeof(saidx_t));
+  s->SA = (saidx_t *)malloc((size_t)cfg->n * sizeof(saidx_t));
+  s->SA0 = (saidx_t *)malloc((size_t)cfg->n * sizeof(saidx_t));
+  if((s->ISA == NULL) || (s->ISA0 == NULL) || (s->SA == NULL) || (s->SA0 == NULL)) {
+    tr_release(s);
+    return NULL;
+  }
+  return s;
+}
+
+/* The first trsort pass over a text of ranks in which a share ties of the
+   positions repeat earlier ones, often overlapping into tandem repeats.
+   The suffixes are grouped by their first depth ranks, and the last one is
+   a unique sentinel. */
+static const saidx_t *cmp_R;
+static saidx_t cmp_n, cmp_depth;
+
+static
+int
+cmp_prefix(const void *p1, const void *p2) {
+  saidx_t i = *(const saidx_t *)p1, j = *(const saidx_t *)p2, k;
+  for(k = 0; k < cmp_depth; ++k) {
+    if(cmp_n <= (i + k)) { return -1; }
+    if(cmp_n <= (j + k)) { return 1; }
+    if(cmp_R[i + k] != cmp_R[j + k]) { return (cmp_R[i + k] < cmp_R[j + k]) ? -1 : 1; }
+  }
+  return (i < j) ? -1 : 1;
+}
+
+static
+void *
+tr_setup_introsort(const config_t *cfg) {
+  tr_state_t *s;
+  saidx_t *R;
+  saidx_t n = cfg->n, i, j, k, len, src;
+
+  if((s = tr_alloc(cfg, n)) == NULL) { return NULL; }
+  if((R = (saidx_t *)malloc((size_t)n * sizeof(saidx_t))) == NULL) { tr_release(s); return NULL; }
+  for(i = 0; i < (n - 1); i += len) {
+    len = 64 + rng_below(960);
+    if((n - 1 - i) < len) { len = n - 1 - i; }
+    if((0 < i) && rng_chance(cfg->ties)) {
+      src = i - 1 - rng_below(MIN(i, 4096));
+      for(j = 0; j < len; ++j) { R[i + j] = R[src + j]; }
+    } else {
+      for(j = 0; j < len; ++j) { R[i + j] = 1 + rng_below(cfg->sigma); }
+    }
+  }
+  R[n - 1] = 0;
+
+  for(i = 0; i < n; ++i) { s->SA0[i] = i; }
+  cmp_R = R, cmp_n = n, cmp_depth = cfg->depth;
+  qsort(s->SA0, (size_t)n, sizeof(saidx_t), cmp_prefix);
+  for(i = n - 1; 0 <= i; i = j) {
+    for(j = i - 1; (0 <= j); --j) {
+      for(k = 0; k < cfg->depth; ++k) {
+        if((n <= (s->SA0[j] + k)) || (n <= (s->SA0[i] + k)) ||
+           (R[s->SA0[j] + k] != R[s->SA0[i] + k])) { break; }
+      }
+      if(k < cfg->depth) { break; }
+    }
+    for(k = j + 1; k <= i; ++k) { s->ISA0[s->SA0[k]] = i; }
+  }
+  free(R);
+  return s;
+}
+
+static
+void
+tr_run_introsort(void *state) {
+  tr_state_t *s = (tr_state_t *)state;
+  saidx_t *first, *last, *end = s->SA + s->cfg.n;
+
+  for(first = s->SA; first < end; first = last) {
+    last = s->SA + s->ISA[*first] + 1;
+    if(1 < (last - first)) {
+      tr_test_introsort(s->ISA, s->ISA + s->cfg.depth, s->SA, first, last, s->cfg.threshold);
+    }
+  }
+}
+
+/* Ranks in [0, sigma), a share ties of them equal to the pivot. */
+static
+void *
+tr_setup_partition(const config_t *cfg) {
+  tr_state_t *s;
+  saidx_t i;
+
+  if((s = tr_alloc(cfg, cfg->n)) == NULL) { return NULL; }
+  for(i = 0; i < cfg->n; ++i) {
+    s->ISA0[i] = rng_chance(cfg->ties) ? cfg->sigma / 2 : rng_below(cfg->sigma);
+    s->SA0[i] = i;
+  }
+  return s;
+}
+
+static
+void
+tr_run_partition(void *state) {
+  tr_state_t *s = (tr_state_t *)state;
+  saidx_t *a, *b;
+  tr_test_partition(s->ISA, s->SA, s->SA, s->SA + s->cfg.n, &a, &b, s->cfg.sigma / 2);
+}
+
+/* A group whose middle partition, a share ties of it, is made of chains
+   of suffixes depth apart that end in the left or the right partition. */
+static
+void *
+tr_setup_copy(const config_t *cfg) {
+  tr_state_t *s;
+  saidx_t *K;
+  saidx_t n = cfg->n, d = cfg->depth, M, nbases, i, j, t, off, v, left, right;
+
+  M = (saidx_t)(cfg->ties * (double)n);
+  if(n <= M) { M = n - 1; }
+  nbases = n - M;
+  if((K = (saidx_t *)calloc((size_t)nbases, sizeof(saidx_t))) == NULL) { return NULL; }
+  for(i = 0; i < M; ++i) { ++K[rng_below(nbases)]; }
+  if((s = tr_alloc(cfg, (M + nbases) * d)) == NULL) { free(K); return NULL; }
+
+  for(j = 0, left = 0; j < nbases; j += 2) { ++left; }
+  s->a = left, s->b = left + M, v = s->b - 1;
+  for(i = 0; i < s->N; ++i) { s->ISA0[i] = n; }
+  for(j = 0, off = 0, left = 0, right = s->b; j < nbases; ++j) {
+    for(t = 1; t <= K[j]; ++t) { s->ISA0[off + (K[j] - t) * d] = v; }
+    s->SA0[((j & 1) == 0) ? left++ : right++] = off + K[j] * d;
+    off += (K[j] + 1) * d;
+  }
+  for(i = s->a; i < s->b; ++i) { s->SA0[i] = 0; }
+  free(K);
+  return s;
+}
+
+static
+void
+tr_run_copy(void *state) {
+  tr_state_t *s = (tr_state_t *)state;
+  tr_test_copy(s->ISA, s->SA, s->SA, s->SA + s->a, s->SA + s->b, s->SA + s->cfg.n, s->cfg.depth);
+}
+
+
+/*- Measurement -*/
+
+static const kernel_t kernels[] = {
+  { "mintrosort", ss_setup, ss_reset, ss_run_mintrosort, ss_release },
+  { "swapmerge", ss_setup_swapmerge, ss_reset, ss_run_swapmerge, ss_release },
+  { "inplacemerge", ss_setup_inplacemerge, ss_reset, ss_run_inplacemerge, ss_release },
+  { "introsort", tr_setup_introsort, tr_reset, tr_run_introsort, tr_release },
+  { "partition", tr_setup_partition, tr_reset, tr_run_partition, tr_release },
+  { "copy", tr_setup_copy, tr_reset, tr_run_copy, tr_release },
+  { NULL, NULL, NULL, NULL, NULL }
+};
+
+/* Returns the wall-clock time in seconds. */
+static
+double
+wallclock(void) {
+#if defined(_OPENMP)
+  return omp_get_wtime();
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#else
+  return (double)clock() / (double)CLOCKS_PER_SEC;
+#endif
+}
+
+/* Times the best of reps runs of a kernel, with the comparisons of one. */
+static
+saint_t
+measure(const kernel_t *k, const config_t *cfg, saint_t reps,
+        double *best, uint64_t *compares) {
+  void *state;
+  double sec;
+  saint_t r;
+
+  rng_state = 2463534242U;
+  if((state = k->setup(cfg)) == NULL) { return -1; }
+  for(r = 0; r < reps; ++r) {
+    k->reset(state);
+    sa_test_compares = 0;
+    sec = wallclock();
+    k->run(state);
+    sec = wallclock() - sec;
+    if((r == 0) || (sec < *best)) { *best = sec; }
+  }
+  *compares = sa_test_compares;
+  k->release(state);
+  return 0;
+}
+
+
+/*- Options -*/
+
+/* Parses a comma separated list of numbers within [lo, hi]. */
+static
+saint_t
+parse_list(const char *s, double *list, double lo, double hi) {
+  char *end;
+  saint_t n;
+
+  for(n = 0; (n < MAXLIST) && (*s != '\0'); ++n) {
+    list[n] = strtod(s, &end);
+    if((end == s) || (list[n] < lo) || (hi < list[n])) { return -1; }
+    if(*end == ',') { ++end; } else if(*end != '\0') { return -1; }
+    s = end;
+  }
+  return (*s == '\0') ? n : -1;
+}
+
+static
+void
+print_help(const char *progname, int status) {
+  saint_t i;
+
+  fprintf(stderr,
+          "kernbench, a sort kernel benchmark, version %s.\n",
+          divsufsort_version());
+  fprintf(stderr, "usage: %s [-k kernel] [-n sizes] [-d depths] [-e ties] [-l length]"
+                  " [-a sigma] [-t threshold] [-r reps]\n", progname);
+  fprintf(stderr, "  -k kernel    the kernel to measure, or all (default: all)\n");
+  fprintf(stderr, "  -n sizes     comma separated group sizes (default: 65536)\n");
+  fprintf(stderr, "  -d depths    comma separated common prefix depths of the ss kernels,\n"
+                  "               or rank distances of the tr kernels (default: 2)\n");
+  fprintf(stderr, "  -e ties      comma separated shares of tied elements (default: 0.1)\n");
+  fprintf(stderr, "  -l length    substring length of the ss kernels (default: 32)\n");
+  fprintf(stderr, "  -a sigma     alphabet size or number of ranks (default: 4)\n");
+  fprintf(stderr, "  -t threshold insertion sort threshold (default: the library's)\n");
+  fprintf(stderr, "  -r reps      time each kernel as the best of reps runs (default: 5)\n");
+  fprintf(stderr, "kernels:");
+  for(i = 0; kernels[i].name != NULL; ++i) { fprintf(stderr, " %s", kernels[i].name); }
+  fprintf(stderr, "\n\n");
+  exit(status);
+}
+
+int
+main(int argc, const char *argv[]) {
+  double sizes[MAXLIST], depths[MAXLIST], ties[MAXLIST];
+  divsufsort_tuning_t tuning;
+  config_t cfg;
+  const char *kname = "all";
+  double best;
+  uint64_t compares;
+  saint_t a, i, j, k, m, nsizes = 1, ndepths = 1, nties = 1, reps = 5, found = 0;
+
+  divsufsort_tuning_default(&tuning);
+  sizes[0] = 65536, depths[0] = 2, ties[0] = 0.1;
+  cfg.length = 32, cfg.sigma = 4, cfg.threshold = tuning.ss_insertionsort_threshold;
+
+  /* Check arguments. */
+  if((1 < argc) &&
+     ((strcmp(argv[1], "-h") == 0) ||
+      (strcmp(argv[1], "--help") == 0))) { print_help(argv[0], EXIT_SUCCESS); }
+  for(a = 1; a < argc; ++a) {
+    if((argv[a][0] != '-') || (a == (argc - 1))) { print_help(argv[0], EXIT_FAILURE); }
+    if(strcmp(argv[a], "-k") == 0) { kname = argv[++a]; }
+    else if(strcmp(argv[a], "-n") == 0) {
+      if((nsizes = parse_list(argv[++a], sizes, 16, 1 << 26)) <= 0) { print_help(argv[0], EXIT_FAILURE); }
+    } else if(strcmp(argv[a], "-d") == 0) {
+      if((ndepths = parse_list(argv[++a], depths, 1, 64)) <= 0) { print_help(argv[0], EXIT_FAILURE); }
+    } else if(strcmp(argv[a], "-e") == 0) {
+      if((nties = parse_list(argv[++a], ties, 0.0, 1.0)) <= 0) { print_help(argv[0], EXIT_FAILURE); }
+    } else if(strcmp(argv[a], "-l") == 0) {
+      if((cfg.length = (saidx_t)atoi(argv[++a])) < 2) { print_help(argv[0], EXIT_FAILURE); }
+    } else if(strcmp(argv[a], "-a") == 0) {
+      cfg.sigma = (saint_t)atoi(argv[++a]);
+      if((cfg.sigma < 2) || (256 < cfg.sigma)) { print_help(argv[0], EXIT_FAILURE); }
+    } else if(strcmp(argv[a], "-t") == 0) {
+      if((cfg.threshold = (saidx_t)atoi(argv[++a])) < 1) { print_help(argv[0], EXIT_FAILURE); }
+    } else if(strcmp(argv[a], "-r") == 0) {
+      if((reps = (saint_t)atoi(argv[++a])) < 1) { print_help(argv[0], EXIT_FAILURE); }
+    } else { print_help(argv[0], EXIT_FAILURE); }
+  }
+  for(j = 0; j < ndepths; ++j) {
+    if(cfg.length <= (saidx_t)depths[j]) {
+      fprintf(stderr, "%s: The depth must be below the substring length.\n", argv[0]);
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  /* Measure every kernel at every setting. */
+  printf("%-14s %9s %6s %6s %10s %10s %10s\n",
+         "kernel", "size", "depth", "ties", "ns/elem", "ns/cmp", "cmp/elem");
+  for(k = 0; kernels[k].name != NULL; ++k) {
+    if((strcmp(kname, "all") != 0) && (strcmp(kname, kernels[k].name) != 0)) { continue; }
+    found = 1;
+    for(i = 0; i < nsizes; ++i) {
+      for(j = 0; j < ndepths; ++j) {
+        for(m = 0; m < nties; ++m) {
+          cfg.n = (saidx_t)sizes[i], cfg.depth = (saidx_t)depths[j], cfg.ties = ties[m];
+          if(measure(kernels + k, &cfg, reps, &best, &compares) != 0) {
+            fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
+            exit(EXIT_FAILURE);
+          }
+          printf("%-14s %9" PRIdSAIDX_T " %6" PRIdSAIDX_T " %6.3f %10.3f %10.3f %10.3f\n",
+                 kernels[k].name, cfg.n, cfg.depth, cfg.ties,
+                 best * 1e9 / (double)cfg.n,
+                 (0 < compares) ? best * 1e9 / (double)compares : 0.0,
+                 (double)compares / (double)cfg.n);
+        }
+      }
+    }
+  }
+  if(found == 0) { print_help(argv[0], EXIT_FAILURE); }
+
+  return 0;
+}
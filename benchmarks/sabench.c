@@ -0,0 +1,801 @@
+/*
+ * sabench.c for libdivsufsort
+ * Copyright (c) 2003-2008 Yuta Mori All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <stdio.h>
+#if HAVE_STRING_H
+# include <string.h>
+#endif
+#if HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#if HAVE_MEMORY_H
+# include <memory.h>
+#endif
+#if HAVE_STDDEF_H
+# include <stddef.h>
+#endif
+#if HAVE_STRINGS_H
+# include <strings.h>
+#endif
+#if HAVE_SYS_TYPES_H
+# include <sys/types.h>
+#endif
+#if HAVE_FORK
+# include <unistd.h>
+# include <sys/wait.h>
+#endif
+#if HAVE_GETRUSAGE
+# include <sys/time.h>
+# include <sys/resource.h>
+#endif
+#include <time.h>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+#include <divsufsort.h>
+
+
+/* The number of sa_search queries, and their length. */
+#define NQUERIES (100000)
+#define QUERYSIZE (16)
+#define MAXCASES (1024)
+#define MAXLIST (16)
+
+/* The exit status of a baseline check that has no baseline to check, which
+   CTest reports as a skipped test. */
+#define EXIT_SKIP (77)
+
+/* The measured operations. */
+enum { OP_SORT, OP_BWT, OP_UNBWT, OP_SEARCH, OP_CHECK, NOPS };
+static const char *opnames[NOPS] = {
+  "divsufsort", "divbwt", "inverse_bw_transform", "sa_search", "sufcheck"
+};
+
+/* The result of one case, as passed back from the process that ran it. */
+typedef struct {
+  double sec[NOPS];
+  long rss; /* peak resident set in KiB, -1 if unknown */
+  int err; /* 0, or 1 if out of memory, 2 if a result was wrong */
+} result_t;
+
+typedef struct {
+  const char *input; /* a generator or a file name */
+  saint_t gen; /* index into generators, -1 for a file */
+  saidx_t n;
+  saint_t threads;
+  result_t r;
+} case_t;
+
+
+/*- Inputs -*/
+
+/* A xorshift generator, so that every input is the same everywhere. */
+static
+unsigned int
+rng_next(unsigned int *x) {
+  *x ^= *x << 13, *x ^= *x >> 17, *x ^= *x << 5;
+  return *x;
+}
+
+static
+void
+gen_random(sauchar_t *T, saidx_t n, saint_t sigma, unsigned int *x) {
+  saidx_t i;
+  for(i = 0; i < n; ++i) { T[i] = (sauchar_t)((rng_next(x) >> 8) % (unsigned int)sigma); }
+}
+
+static void gen_random2(sauchar_t *T, saidx_t n, unsigned int *x) { gen_random(T, n, 2, x); }
+static void gen_random4(sauchar_t *T, saidx_t n, unsigned int *x) { gen_random(T, n, 4, x); }
+static void gen_random26(sauchar_t *T, saidx_t n, unsigned int *x) { gen_random(T, n, 26, x); }
+static void gen_random95(sauchar_t *T, saidx_t n, unsigned int *x) { gen_random(T, n, 95, x); }
+static void gen_random256(sauchar_t *T, saidx_t n, unsigned int *x) { gen_random(T, n, 256, x); }
+
+/* The Fibonacci word, f(k+1) = f(k) f(k-1), built in place since f(k-1)
+   is a prefix of f(k). */
+static
+void
+gen_fibonacci(sauchar_t *T, saidx_t n, unsigned int *x) {
+  saidx_t i, len, prev, t;
+  (void)x;
+  T[0] = 'a';
+  if(1 < n) { T[1] = 'b'; }
+  for(len = 2, prev = 1; len < n; t = len, len += prev, prev = t) {
+    for(i = 0; (i < prev) && ((len + i) < n); ++i) { T[len + i] = T[i]; }
+  }
+}
+
+static
+void
+gen_thuemorse(sauchar_t *T, saidx_t n, unsigned int *x) {
+  saidx_t i, j;
+  saint_t p;
+  (void)x;
+  for(i = 0; i < n; ++i) {
+    for(j = i, p = 0; j != 0; j &= j - 1) { p ^= 1; }
+    T[i] = (sauchar_t)('a' + p);
+  }
+}
+
+/* A random period of 1000 letters, repeated. */
+static
+void
+gen_periodic(sauchar_t *T, saidx_t n, unsigned int *x) {
+  saidx_t i;
+  for(i = 0; i < n; ++i) {
+    T[i] = (i < 1000) ? (sauchar_t)('a' + (rng_next(x) >> 8) % 26) : T[i - 1000];
+  }
+}
+
+/* The periodic text with one letter in a thousand changed. */
+static
+void
+gen_nearperiodic(sauchar_t *T, saidx_t n, unsigned int *x) {
+  saidx_t i;
+  gen_periodic(T, n, x);
+  for(i = n / 1000; 0 < i; --i) {
+    T[(rng_next(x) >> 1) % (unsigned int)n] = (sauchar_t)('a' + (rng_next(x) >> 8) % 26);
+  }
+}
+
+/* ACGT text in which half of the segments are mutated copies of earlier
+   ones, like the repeats of a genome. */
+static
+void
+gen_dna(sauchar_t *T, saidx_t n, unsigned int *x) {
+  static const sauchar_t acgt[4] = { 'A', 'C', 'G', 'T' };
+  saidx_t i, j, len, src;
+  for(i = 0; i < n; i += len) {
+    if((i < 10000) || (rng_next(x) & 1)) {
+      len = 1 + (saidx_t)(rng_next(x) % 1000);
+      if((n - i) < len) { len = n - i; }
+      for(j = 0; j < len; ++j) { T[i + j] = acgt[(rng_next(x) >> 8) & 3]; }
+    } else {
+      len = 100 + (saidx_t)(rng_next(x) % 5000);
+      if((n - i) < len) { len = n - i; }
+      src = (saidx_t)((rng_next(x) >> 1) % (unsigned int)(i - 100));
+      for(j = 0; j < len; ++j) {
+        T[i + j] = ((rng_next(x) % 100) == 0) ? acgt[(rng_next(x) >> 8) & 3] : T[src + j];
+      }
+    }
+  }
+}
+
+/* Records of up to 256 letters, each padded with zeros to 1024 bytes, half
+   of them repeating an earlier record, like a table dumped to disk. */
+static
+void
+gen_padded(sauchar_t *T, saidx_t n, unsigned int *x) {
+  saidx_t i, j, len, src;
+  memset(T, 0, (size_t)n);
+  for(i = 0; i < n; i += 1024) {
+    if((i == 0) || (rng_next(x) & 1)) {
+      len = 16 + (saidx_t)(rng_next(x) % 241);
+      for(j = 0; (j < len) && ((i + j) < n); ++j) { T[i + j] = (sauchar_t)('a' + (rng_next(x) >> 8) % 26); }
+    } else {
+      src = (saidx_t)(rng_next(x) % (unsigned int)(i / 1024)) * 1024;
+      for(j = 0; (j < 256) && ((i + j) < n); ++j) { T[i + j] = T[src + j]; }
+    }
+  }
+}
+
+static
+void
+gen_same(sauchar_t *T, saidx_t n, unsigned int *x) {
+  (void)x;
+  memset(T, 'a', (size_t)n);
+}
+
+static const struct {
+  const char *name;
+  void (*fn)(sauchar_t *T, saidx_t n, unsigned int *x);
+} generators[] = {
+  { "random2", gen_random2 },
+  { "random4", gen_random4 },
+  { "random26", gen_random26 },
+  { "random95", gen_random95 },
+  { "random256", gen_random256 },
+  { "fibonacci", gen_fibonacci },
+  { "thuemorse", gen_thuemorse },
+  { "periodic", gen_periodic },
+  { "nearperiodic", gen_nearperiodic },
+  { "dna", gen_dna },
+  { "padded", gen_padded },
+  { "same", gen_same },
+  { NULL, NULL }
+};
+
+
+/*- Measurement -*/
+
+/* Returns the wall-clock time in seconds. */
+static
+double
+wallclock(void) {
+#if defined(_OPENMP)
+  return omp_get_wtime();
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#else
+  return (double)clock() / (double)CLOCKS_PER_SEC;
+#endif
+}
+
+/* Returns the peak resident set of this process in KiB, or -1. */
+static
+long
+peak_rss(void) {
+#if HAVE_GETRUSAGE
+  struct rusage ru;
+  if(getrusage(RUSAGE_SELF, &ru) != 0) { return -1; }
+# if defined(__APPLE__)
+  return (long)(ru.ru_maxrss / 1024);
+# else
+  return (long)ru.ru_maxrss;
+# endif
+#else
+  return -1;
+#endif
+}
+
+#define BEST(_sec, _op, _reps, _stmt)\
+  do {\
+    double _t;\
+    saint_t _r;\
+    for(_r = 0; _r < (_reps); ++_r) {\
+      _t = wallclock();\
+      _stmt;\
+      _t = wallclock() - _t;\
+      if((_r == 0) || (_t < (_sec)[_op])) { (_sec)[_op] = _t; }\
+    }\
+  } while(0)
+
+#define TIMED(_ops, _op) (((_ops) & (1U << (_op))) != 0)
+
+/* Runs the operations of a case in ops, keeping the best of reps runs each.
+   An operation another one depends on, or that checks another's result, is
+   run once if it is not in ops. */
+static
+void
+run_case(const case_t *c, unsigned int ops, saint_t reps, result_t *r) {
+  sauchar_t *T, *U, *V;
+  saidx_t *SA, *Q;
+  void *map = NULL;
+  size_t mapsize;
+  saidx_t n = c->n, i, pidx = 0, hits = 0, left;
+  unsigned int x;
+  saint_t err = 0, size;
+
+  memset(r, 0, sizeof(result_t));
+#ifdef _OPENMP
+  omp_set_num_threads(c->threads);
+#endif
+
+  /* Build or map the input. */
+  if(c->gen < 0) {
+    if(sa_mmap(c->input, SA_MMAP_POPULATE, &map, &mapsize) != 0) { r->err = 1; return; }
+    T = (sauchar_t *)map;
+  } else if((T = (sauchar_t *)malloc((size_t)n)) != NULL) {
+    x = 2463534242U + (unsigned int)c->gen;
+    generators[c->gen].fn(T, n, &x);
+  }
+  SA = (saidx_t *)malloc((size_t)n * sizeof(saidx_t));
+  U = (sauchar_t *)malloc((size_t)n);
+  V = (sauchar_t *)malloc((size_t)n);
+  Q = (saidx_t *)malloc(NQUERIES * sizeof(saidx_t));
+  if((T == NULL) || (SA == NULL) || (U == NULL) || (V == NULL) || (Q == NULL)) {
+    r->err = 1;
+  } else {
+    /* The queries start at random positions of the text. */
+    size = (QUERYSIZE < n) ? QUERYSIZE : (saint_t)n;
+    for(i = 0, x = 88675123U; i < NQUERIES; ++i) {
+      Q[i] = (saidx_t)((rng_next(&x) >> 1) % (unsigned int)(n - size + 1));
+    }
+
+    if(TIMED(ops, OP_SORT) || TIMED(ops, OP_CHECK) || TIMED(ops, OP_SEARCH)) {
+      BEST(r->sec, OP_SORT, TIMED(ops, OP_SORT) ? reps : 1, err |= divsufsort(T, SA, n));
+      BEST(r->sec, OP_CHECK, TIMED(ops, OP_CHECK) ? reps : 1, err |= sufcheck(T, SA, n, 0));
+      if(TIMED(ops, OP_SEARCH)) {
+        BEST(r->sec, OP_SEARCH, reps,
+             for(i = 0, hits = 0; i < NQUERIES; ++i) {
+               hits += (0 < sa_search(T, n, T + Q[i], size, SA, n, &left));
+             });
+        if(hits != NQUERIES) { r->err = 2; }
+      }
+      if(err != 0) { r->err = 2; }
+    }
+    if((r->err == 0) && (TIMED(ops, OP_BWT) || TIMED(ops, OP_UNBWT))) {
+      BEST(r->sec, OP_BWT, TIMED(ops, OP_BWT) ? reps : 1, pidx = divbwt(T, U, SA, n));
+      if(pidx < 0) { r->err = 1; }
+      BEST(r->sec, OP_UNBWT, TIMED(ops, OP_UNBWT) ? reps : 1,
+           err |= inverse_bw_transform(U, V, SA, n, pidx));
+      if((err != 0) || (memcmp(T, V, (size_t)n) != 0)) { r->err = 2; }
+    }
+  }
+  free(Q);
+  free(V);
+  free(U);
+  free(SA);
+  if(map != NULL) { sa_munmap(map, mapsize); } else { free(T); }
+
+  r->rss = peak_rss();
+}
+
+/* Runs a case in a child process so that its peak memory is its own. */
+static
+void
+run_isolated(const case_t *c, unsigned int ops, saint_t reps, result_t *r) {
+#if HAVE_FORK
+  int fd[2], status;
+  pid_t pid;
+
+  fflush(NULL);
+  if(pipe(fd) == 0) {
+    if((pid = fork()) == 0) {
+      close(fd[0]);
+      run_case(c, ops, reps, r);
+      _exit((write(fd[1], r, sizeof(result_t)) == sizeof(result_t)) ? 0 : 1);
+    }
+    close(fd[1]);
+    if((0 < pid) && (read(fd[0], r, sizeof(result_t)) == sizeof(result_t))) {
+      close(fd[0]);
+      waitpid(pid, &status, 0);
+      return;
+    }
+    close(fd[0]);
+    if(0 < pid) { waitpid(pid, &status, 0); }
+  }
+#endif
+  run_case(c, ops, reps, r);
+}
+
+
+/*- Output -*/
+
+/* Returns the throughput of an operation, in MB or queries per second. */
+static
+double
+throughput(const case_t *c, saint_t op) {
+  double sec = c->r.sec[op];
+  if(sec <= 0.0) { return 0.0; }
+  return (op == OP_SEARCH) ? NQUERIES / sec : ((double)c->n / 1e6) / sec;
+}
+
+/* Prints a string as a JSON string. */
+static
+void
+print_string(FILE *fp, const char *s) {
+  fputc('"', fp);
+  for(; *s != '\0'; ++s) {
+    if((*s == '"') || (*s == '\\')) { fputc('\\', fp); }
+    if((unsigned char)*s < 0x20) { fprintf(fp, "\\u%04x", (unsigned char)*s); }
+    else { fputc(*s, fp); }
+  }
+  fputc('"', fp);
+}
+
+static
+void
+print_json(FILE *fp, const case_t *cases, saint_t ncases, unsigned int ops, saint_t reps) {
+  const case_t *c, *base;
+  double sec;
+  saint_t i, j, k;
+
+  fprintf(fp, "{\n  \"version\": ");
+  print_string(fp, divsufsort_version());
+#ifdef _OPENMP
+  fprintf(fp, ",\n  \"openmp\": true");
+#else
+  fprintf(fp, ",\n  \"openmp\": false");
+#endif
+  fprintf(fp, ",\n  \"index_bits\": %d,\n  \"reps\": %d,\n  \"queries\": %d,\n  \"cases\": [",
+          (int)(sizeof(saidx_t) * 8), (int)reps, NQUERIES);
+  for(i = 0; i < ncases; ++i) {
+    c = cases + i;
+    /* Efficiency is relative to the same input and size on one thread. */
+    for(j = 0, base = NULL; j < ncases; ++j) {
+      if((cases[j].threads == 1) && (cases[j].n == c->n) &&
+         (strcmp(cases[j].input, c->input) == 0) && (cases[j].r.err == 0)) { base = cases + j; }
+    }
+    fprintf(fp, "%s\n    {\"input\": ", (i == 0) ? "" : ",");
+    print_string(fp, c->input);
+    fprintf(fp, ", \"size\": %" PRIdSAIDX_T ", \"threads\": %d", c->n, (int)c->threads);
+    if(c->r.err != 0) {
+      fprintf(fp, ", \"error\": \"%s\"}",
+              (c->r.err == 1) ? "cannot allocate memory" : "wrong result");
+      continue;
+    }
+    fprintf(fp, ", \"peak_rss_kib\": %ld", c->r.rss);
+    for(k = 0; k < NOPS; ++k) {
+      if(!TIMED(ops, k)) { continue; }
+      sec = c->r.sec[k];
+      fprintf(fp, ",\n     \"%s\": {\"seconds\": %.6f", opnames[k], sec);
+      if(k == OP_SEARCH) {
+        fprintf(fp, ", \"queries_per_sec\": %.1f", throughput(c, k));
+      } else {
+        fprintf(fp, ", \"mb_per_sec\": %.3f", throughput(c, k));
+      }
+      if((base != NULL) && (0.0 < sec)) {
+        fprintf(fp, ", \"efficiency\": %.3f", base->r.sec[k] / (sec * c->threads));
+      } else {
+        fprintf(fp, ", \"efficiency\": null");
+      }
+      fprintf(fp, "}");
+    }
+    fprintf(fp, "}");
+  }
+  fprintf(fp, "\n  ]\n}\n");
+}
+
+
+/*- Baselines -*/
+
+/* A baseline file has one line per case and operation,
+     operation size threads throughput input
+   and lines starting with '#' are comments. */
+static
+void
+write_baseline(FILE *fp, const case_t *cases, saint_t ncases, unsigned int ops) {
+  const case_t *c;
+  saint_t i, k;
+
+  fprintf(fp, "# sabench baseline, libdivsufsort %s, %d-bit index\n",
+          divsufsort_version(), (int)(sizeof(saidx_t) * 8));
+  fprintf(fp, "# operation size threads throughput input\n");
+  for(i = 0; i < ncases; ++i) {
+    c = cases + i;
+    if(c->r.err != 0) { continue; }
+    for(k = 0; k < NOPS; ++k) {
+      if(!TIMED(ops, k)) { continue; }
+      fprintf(fp, "%s %" PRIdSAIDX_T " %d %.3f %s\n",
+              opnames[k], c->n, (int)c->threads, throughput(c, k), c->input);
+    }
+  }
+}
+
+/* Compares the cases against a baseline file. An operation regresses if its
+   throughput relative to the baseline, averaged over the cases, is lower by
+   more than tolerance percent; a single case is too noisy to go by. Returns
+   0 if no operation regresses, 1 if one does, and -1 if the baseline file
+   cannot be read. */
+static
+saint_t
+check_baseline(const char *progname, const char *fname,
+               const case_t *cases, saint_t ncases, unsigned int ops, double tolerance) {
+  static unsigned int seen[MAXCASES];
+  char line[1024], op[32];
+  const case_t *c;
+  FILE *fp;
+  double sum[NOPS], base, rate, change;
+  saint_t count[NOPS];
+  long n;
+  int threads, pos;
+  size_t len;
+  saint_t i, k, regressed = 0;
+
+  if((fp = fopen(fname, "r")) == NULL) { return -1; }
+  memset(seen, 0, sizeof(seen));
+  for(k = 0; k < NOPS; ++k) { sum[k] = 0.0, count[k] = 0; }
+  while(fgets(line, sizeof(line), fp) != NULL) {
+    for(len = strlen(line); (0 < len) && ((line[len - 1] == '\n') || (line[len - 1] == '\r')); --len) {
+      line[len - 1] = '\0';
+    }
+    if((line[0] == '#') || (line[0] == '\0')) { continue; }
+    if(sscanf(line, "%31s %ld %d %lf %n", op, &n, &threads, &base, &pos) != 4) { continue; }
+    for(k = 0; (k < NOPS) && (strcmp(opnames[k], op) != 0); ++k) { }
+    if((k == NOPS) || !TIMED(ops, k) || (base <= 0.0)) { continue; }
+    for(i = 0; i < ncases; ++i) {
+      c = cases + i;
+      if((c->r.err != 0) || (c->n != (saidx_t)n) || (c->threads != threads) ||
+         (strcmp(c->input, line + pos) != 0)) { continue; }
+      rate = throughput(c, k), change = (rate - base) * 100.0 / base;
+      fprintf(stderr, "%s: %s on %s, %" PRIdSAIDX_T " bytes, %d thread%s: %.3f, baseline %.3f (%+.1f%%)\n",
+              progname, opnames[k], c->input, c->n, (int)c->threads, (c->threads == 1) ? "" : "s",
+              rate, base, change);
+      if(!TIMED(seen[i], k)) { sum[k] += rate / base, ++count[k]; }
+      seen[i] |= 1U << k;
+    }
+  }
+  fclose(fp);
+
+  for(i = 0; i < ncases; ++i) {
+    c = cases + i;
+    for(k = 0; k < NOPS; ++k) {
+      if((c->r.err == 0) && TIMED(ops, k) && !TIMED(seen[i], k)) {
+        fprintf(stderr, "%s: %s on %s, %" PRIdSAIDX_T " bytes, %d thread%s: no baseline\n",
+                progname, opnames[k], c->input, c->n, (int)c->threads, (c->threads == 1) ? "" : "s");
+      }
+    }
+  }
+  for(k = 0; k < NOPS; ++k) {
+    if(count[k] == 0) { continue; }
+    change = (sum[k] / count[k] - 1.0) * 100.0;
+    fprintf(stderr, "%s: %s: %+.1f%% on average over %d case%s, tolerance %.1f%%%s\n",
+            progname, opnames[k], change, (int)count[k], (count[k] == 1) ? "" : "s",
+            tolerance, (change < -tolerance) ? " REGRESSED" : "");
+    if(change < -tolerance) { regressed = 1; }
+  }
+
+  return regressed;
+}
+
+
+/*- Options -*/
+
+/* Parses a comma separated list of sizes with optional k, m or g suffixes. */
+static
+saint_t
+parse_sizes(const char *s, saidx_t *sizes) {
+  char *end;
+  double v;
+  saint_t n;
+
+  for(n = 0; (n < MAXLIST) && (*s != '\0'); ++n) {
+    v = strtod(s, &end);
+    if(end == s) { return -1; }
+    if((*end == 'k') || (*end == 'K')) { v *= 1024.0, ++end; }
+    else if((*end == 'm') || (*end == 'M')) { v *= 1048576.0, ++end; }
+    else if((*end == 'g') || (*end == 'G')) { v *= 1073741824.0, ++end; }
+    if((v < 1.0) || (2147483647.0 <= v)) { return -1; }
+    sizes[n] = (saidx_t)v;
+    if(*end == ',') { ++end; } else if(*end != '\0') { return -1; }
+    s = end;
+  }
+  return (*s == '\0') ? n : -1;
+}
+
+static
+saint_t
+parse_threads(const char *s, saint_t *threads) {
+  char *end;
+  long v;
+  saint_t n;
+
+  for(n = 0; (n < MAXLIST) && (*s != '\0'); ++n) {
+    v = strtol(s, &end, 10);
+    if((end == s) || (v < 1) || (1024 < v)) { return -1; }
+    threads[n] = (saint_t)v;
+    if(*end == ',') { ++end; } else if(*end != '\0') { return -1; }
+    s = end;
+  }
+  return (*s == '\0') ? n : -1;
+}
+
+/* Returns the set of operations named in a comma separated list, or 0. */
+static
+unsigned int
+parse_ops(const char *s) {
+  const char *end;
+  size_t len;
+  unsigned int ops = 0;
+  saint_t k;
+
+  for(; *s != '\0'; s = (*end == ',') ? end + 1 : end) {
+    for(end = s; (*end != ',') && (*end != '\0'); ++end) { }
+    len = (size_t)(end - s);
+    for(k = 0; k < NOPS; ++k) {
+      if((strlen(opnames[k]) == len) && (strncmp(opnames[k], s, len) == 0)) { break; }
+    }
+    if(k == NOPS) { return 0; }
+    ops |= 1U << k;
+  }
+  return ops;
+}
+
+/* Marks the generators named in a comma separated list. */
+static
+saint_t
+parse_inputs(const char *s, saint_t *use) {
+  const char *end;
+  size_t len;
+  saint_t i;
+
+  if(strcmp(s, "none") == 0) { return 0; }
+  for(; *s != '\0'; s = (*end == ',') ? end + 1 : end) {
+    for(end = s; (*end != ',') && (*end != '\0'); ++end) { }
+    len = (size_t)(end - s);
+    for(i = 0; generators[i].name != NULL; ++i) {
+      if((strlen(generators[i].name) == len) && (strncmp(generators[i].name, s, len) == 0)) { break; }
+    }
+    if(generators[i].name == NULL) { return -1; }
+    use[i] = 1;
+  }
+  return 0;
+}
+
+static
+void
+print_help(const char *progname, int status) {
+  saint_t i;
+
+  fprintf(stderr,
+          "sabench, a suffix array benchmark, version %s.\n",
+          divsufsort_version());
+  fprintf(stderr, "usage: %s [-s sizes] [-t threads] [-g inputs] [-p ops] [-r reps] [-o OUTFILE]\n"
+                  "       [-b BASELINE [-x percent] | -w BASELINE] [FILE ...]\n", progname);
+  fprintf(stderr, "  -s sizes    comma separated sizes of the generated inputs (default: 1m,8m)\n");
+  fprintf(stderr, "  -t threads  comma separated thread counts (default: 1 and all)\n");
+  fprintf(stderr, "  -g inputs   comma separated generated inputs, or none (default: all)\n");
+  fprintf(stderr, "  -p ops      comma separated operations to time (default: all)\n");
+  fprintf(stderr, "  -r reps     time each operation as the best of reps runs (default: 3)\n");
+  fprintf(stderr, "  -o OUTFILE  write the JSON report to OUTFILE (default: stdout)\n");
+  fprintf(stderr, "  -b BASELINE fail if an operation is slower than in BASELINE, on average\n");
+  fprintf(stderr, "              over the cases, by more than\n");
+  fprintf(stderr, "  -x percent  percent (default: 10)\n");
+  fprintf(stderr, "  -w BASELINE write the throughputs to BASELINE\n");
+  fprintf(stderr, "  FILE ...    also run on these files, each as a whole\n");
+  fprintf(stderr, "inputs:");
+  for(i = 0; generators[i].name != NULL; ++i) { fprintf(stderr, " %s", generators[i].name); }
+  fprintf(stderr, "\nops:");
+  for(i = 0; i < NOPS; ++i) { fprintf(stderr, " %s", opnames[i]); }
+  fprintf(stderr, "\n\n");
+  exit(status);
+}
+
+int
+main(int argc, const char *argv[]) {
+  static case_t cases[MAXCASES];
+  static saint_t use[sizeof(generators) / sizeof(generators[0])];
+  saidx_t sizes[MAXLIST];
+  saint_t threads[MAXLIST];
+  const char *ofname = NULL, *bfname = NULL, *wfname = NULL;
+  FILE *ofp;
+  double tolerance = 10.0, sec;
+  unsigned int ops = (1U << NOPS) - 1;
+  void *map;
+  size_t mapsize;
+  case_t *c;
+  saint_t a, i, j, k, nsizes, nthreads, ncases = 0, reps = 3, all = 1, failed = 0;
+
+  sizes[0] = 1 << 20, sizes[1] = 8 << 20, nsizes = 2;
+  threads[0] = 1, nthreads = 1;
+#ifdef _OPENMP
+  if(1 < (threads[1] = omp_get_num_procs())) { nthreads = 2; }
+#endif
+
+  /* Check arguments. */
+  if((1 < argc) &&
+     ((strcmp(argv[1], "-h") == 0) ||
+      (strcmp(argv[1], "--help") == 0))) { print_help(argv[0], EXIT_SUCCESS); }
+  for(a = 1; (a < argc) && (argv[a][0] == '-') && (argv[a][1] != '\0'); ++a) {
+    if(a == (argc - 1)) { print_help(argv[0], EXIT_FAILURE); }
+    if(strcmp(argv[a], "-s") == 0) {
+      if((nsizes = parse_sizes(argv[++a], sizes)) <= 0) { print_help(argv[0], EXIT_FAILURE); }
+    } else if(strcmp(argv[a], "-t") == 0) {
+      if((nthreads = parse_threads(argv[++a], threads)) <= 0) { print_help(argv[0], EXIT_FAILURE); }
+    } else if(strcmp(argv[a], "-g") == 0) {
+      all = 0;
+      if(parse_inputs(argv[++a], use) != 0) { print_help(argv[0], EXIT_FAILURE); }
+    } else if(strcmp(argv[a], "-p") == 0) {
+      if((ops = parse_ops(argv[++a])) == 0) { print_help(argv[0], EXIT_FAILURE); }
+    } else if(strcmp(argv[a], "-r") == 0) {
+      if((reps = (saint_t)atoi(argv[++a])) < 1) { print_help(argv[0], EXIT_FAILURE); }
+    } else if(strcmp(argv[a], "-o") == 0) {
+      ofname = argv[++a];
+    } else if(strcmp(argv[a], "-b") == 0) {
+      bfname = argv[++a];
+    } else if(strcmp(argv[a], "-x") == 0) {
+      tolerance = atof(argv[++a]);
+      if((tolerance < 0.0) || (100.0 <= tolerance)) { print_help(argv[0], EXIT_FAILURE); }
+    } else if(strcmp(argv[a], "-w") == 0) {
+      wfname = argv[++a];
+    } else { print_help(argv[0], EXIT_FAILURE); }
+  }
+  if((bfname != NULL) && (wfname != NULL)) { print_help(argv[0], EXIT_FAILURE); }
+  if((bfname != NULL) && ((ofp = fopen(bfname, "r")) == NULL)) {
+    fprintf(stderr, "%s: No baseline `%s', skipping the check.\n", argv[0], bfname);
+    return EXIT_SKIP;
+  } else if(bfname != NULL) { fclose(ofp); }
+#ifndef _OPENMP
+  if((1 < nthreads) || (threads[0] != 1)) {
+    fprintf(stderr, "%s: Built without OpenMP, running on one thread only.\n", argv[0]);
+    threads[0] = 1, nthreads = 1;
+  }
+#endif
+
+  /* List the cases. */
+  for(i = 0; generators[i].name != NULL; ++i) {
+    if((all == 0) && (use[i] == 0)) { continue; }
+    for(j = 0; j < nsizes; ++j) {
+      for(k = 0; (k < nthreads) && (ncases < MAXCASES); ++k) {
+        c = cases + ncases++;
+        c->input = generators[i].name, c->gen = i, c->n = sizes[j], c->threads = threads[k];
+      }
+    }
+  }
+  for(; a < argc; ++a) {
+    if(sa_mmap(argv[a], SA_MMAP_RANDOM, &map, &mapsize) != 0) {
+      fprintf(stderr, "%s: Cannot map file `%s': ", argv[0], argv[a]);
+      perror(NULL);
+      exit(EXIT_FAILURE);
+    }
+    sa_munmap(map, mapsize);
+    if((mapsize == 0) || ((sizeof(saidx_t) == 4) && (0x7fffffff <= mapsize))) {
+      fprintf(stderr, "%s: Input file `%s' is empty or too big.\n", argv[0], argv[a]);
+      exit(EXIT_FAILURE);
+    }
+    for(k = 0; (k < nthreads) && (ncases < MAXCASES); ++k) {
+      c = cases + ncases++;
+      c->input = argv[a], c->gen = -1, c->n = (saidx_t)mapsize, c->threads = threads[k];
+    }
+  }
+
+  /* Run them. */
+  for(i = 0; i < ncases; ++i) {
+    c = cases + i;
+    fprintf(stderr, "%s: %s, %" PRIdSAIDX_T " bytes, %d thread%s ... ",
+            argv[0], c->input, c->n, (int)c->threads, (c->threads == 1) ? "" : "s");
+    run_isolated(c, ops, reps, &c->r);
+    if(c->r.err != 0) {
+      fprintf(stderr, "%s\n", (c->r.err == 1) ? "cannot allocate memory" : "WRONG RESULT");
+      failed = 1;
+    } else {
+      for(k = 0, sec = 0.0; k < NOPS; ++k) { if(TIMED(ops, k)) { sec += c->r.sec[k]; } }
+      fprintf(stderr, "%.4f sec\n", sec);
+    }
+  }
+
+  /* Write the report. */
+  if(ofname == NULL) { ofp = stdout; }
+  else if((ofp = fopen(ofname, "w")) == NULL) {
+    fprintf(stderr, "%s: Cannot open file `%s': ", argv[0], ofname);
+    perror(NULL);
+    exit(EXIT_FAILURE);
+  }
+  print_json(ofp, cases, ncases, ops, reps);
+  if((ofp != stdout) && (fclose(ofp) != 0)) {
+    fprintf(stderr, "%s: Cannot write to `%s': ", argv[0], ofname);
+    perror(NULL);
+    exit(EXIT_FAILURE);
+  }
+
+  /* Refresh or check the baseline. */
+  if(wfname != NULL) {
+    if(failed != 0) {
+      fprintf(stderr, "%s: Not writing `%s' after a failed case.\n", argv[0], wfname);
+      exit(EXIT_FAILURE);
+    }
+    if(((ofp = fopen(wfname, "w")) == NULL) ||
+       (write_baseline(ofp, cases, ncases, ops), fclose(ofp) != 0)) {
+      fprintf(stderr, "%s: Cannot write to `%s': ", argv[0], wfname);
+      perror(NULL);
+      exit(EXIT_FAILURE);
+    }
+    fprintf(stderr, "%s: Baseline written to `%s'\n", argv[0], wfname);
+  } else if((bfname != NULL) && (failed == 0)) {
+    if((i = check_baseline(argv[0], bfname, cases, ncases, ops, tolerance)) < 0) {
+      fprintf(stderr, "%s: No baseline `%s', skipping the check.\n", argv[0], bfname);
+      return EXIT_SKIP;
+    }
+    if(i != 0) { failed = 1; }
+  }
+
+  return (failed != 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,236 @@
+/*
+ * autotune.c for libdivsufsort
+ * Copyright (c) 2003-2008 Yuta Mori All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <stdio.h>
+#if HAVE_STRING_H
+# include <string.h>
+#endif
+#if HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#if HAVE_MEMORY_H
+# include <memory.h>
+#endif
+#if HAVE_STDDEF_H
+# include <stddef.h>
+#endif
+#if HAVE_STRINGS_H
+# include <strings.h>
+#endif
+#if HAVE_SYS_TYPES_H
+# include <sys/types.h>
+#endif
+#include <time.h>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
+#include <divsufsort.h>
+
+
+/* The sample is taken from this many evenly spaced pieces of the input. */
+#define SAMPLE_PIECES (16)
+
+/* Candidate values of each parameter. A budget candidate b stands for
+   b / 12 chances per doubling. */
+static const saint_t blocksizes[] = { 0, 256, 512, 1024, 2048, 4096, 8192, -1 };
+static const saint_t thresholds[] = { 4, 6, 8, 12, 16, 24, 32, -1 };
+static const saint_t budgets[] = { 4, 6, 8, 9, 12, 18, -1 };
+
+
+/* Returns the wall-clock time in seconds. */
+static
+double
+wallclock(void) {
+#if defined(_OPENMP)
+  return omp_get_wtime();
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#else
+  return (double)clock() / (double)CLOCKS_PER_SEC;
+#endif
+}
+
+/* Returns the best of reps runs of divsufsort_tuned. */
+static
+double
+measure(const sauchar_t *T, saidx_t *SA, saidx_t n,
+        const divsufsort_tuning_t *tuning, saint_t reps) {
+  double best = -1.0, sec;
+  saint_t i;
+
+  for(i = 0; i < reps; ++i) {
+    sec = wallclock();
+    if(divsufsort_tuned(T, SA, n, tuning) != 0) { return -1.0; }
+    sec = wallclock() - sec;
+    if((best < 0.0) || (sec < best)) { best = sec; }
+  }
+  return best;
+}
+
+/* Sets parameter k of a tuning to v. */
+static
+void
+setparam(divsufsort_tuning_t *tuning, saint_t k, saint_t v) {
+  switch(k) {
+  case 0: tuning->ss_blocksize = v; break;
+  case 1: tuning->ss_insertionsort_threshold = v; break;
+  case 2: tuning->tr_insertionsort_threshold = v; break;
+  default: tuning->tr_budget_num = v, tuning->tr_budget_den = 12; break;
+  }
+}
+
+static
+void
+print_tuning(const char *prefix, const divsufsort_tuning_t *tuning, double sec) {
+  fprintf(stderr,
+          "%sblocksize %" PRIdSAINT_T ", ss threshold %" PRIdSAINT_T
+          ", tr threshold %" PRIdSAINT_T ", budget %" PRIdSAINT_T "/%" PRIdSAINT_T
+          ": %.4f sec\n",
+          prefix, tuning->ss_blocksize,
+          tuning->ss_insertionsort_threshold, tuning->tr_insertionsort_threshold,
+          tuning->tr_budget_num, tuning->tr_budget_den, sec);
+}
+
+static
+void
+print_help(const char *progname, int status) {
+  fprintf(stderr,
+          "autotune, a sort parameter tuner, version %s.\n",
+          divsufsort_version());
+  fprintf(stderr, "usage: %s [-s size] [-r reps] INFILE PROFILE\n", progname);
+  fprintf(stderr, "  -s size   tune on a sample of size bytes (default: 8388608)\n");
+  fprintf(stderr, "  -r reps   time each candidate as the best of reps runs (default: 3)\n\n");
+  exit(status);
+}
+
+int
+main(int argc, const char *argv[]) {
+  static const saint_t *candidates[4] = { blocksizes, thresholds, thresholds, budgets };
+  const char *fname, *ofname;
+  divsufsort_tuning_t best, cur;
+  sauchar_t *T;
+  saidx_t *SA;
+  void *map;
+  size_t mapsize, piece, i;
+  saidx_t n, size = 8 << 20;
+  double bestsec, defsec, sec;
+  saint_t a, j, k, pass, reps = 3, improved;
+
+  /* Check arguments. */
+  if((argc == 1) ||
+     (strcmp(argv[1], "-h") == 0) ||
+     (strcmp(argv[1], "--help") == 0)) { print_help(argv[0], EXIT_SUCCESS); }
+  for(a = 1; (a < (argc - 2)) && (argv[a][0] == '-'); ++a) {
+    if((strcmp(argv[a], "-s") == 0) && (a < (argc - 3))) {
+      size = (saidx_t)atoi(argv[++a]);
+      if(size < 1) { print_help(argv[0], EXIT_FAILURE); }
+    } else if((strcmp(argv[a], "-r") == 0) && (a < (argc - 3))) {
+      reps = (saint_t)atoi(argv[++a]);
+      if(reps < 1) { print_help(argv[0], EXIT_FAILURE); }
+    } else { print_help(argv[0], EXIT_FAILURE); }
+  }
+  if(a != (argc - 2)) { print_help(argv[0], EXIT_FAILURE); }
+  fname = argv[a], ofname = argv[a + 1];
+
+  /* Map the input and gather the sample. */
+  if(sa_mmap(fname, SA_MMAP_RANDOM, &map, &mapsize) != 0) {
+    fprintf(stderr, "%s: Cannot map file `%s': ", argv[0], fname);
+    perror(NULL);
+    exit(EXIT_FAILURE);
+  }
+  if(mapsize == 0) {
+    fprintf(stderr, "%s: Input file `%s' is empty.\n", argv[0], fname);
+    exit(EXIT_FAILURE);
+  }
+  n = ((size_t)size < mapsize) ? size : (saidx_t)mapsize;
+  T = (sauchar_t *)malloc((size_t)n * sizeof(sauchar_t));
+  SA = (saidx_t *)malloc((size_t)n * sizeof(saidx_t));
+  if((T == NULL) || (SA == NULL)) {
+    fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
+    exit(EXIT_FAILURE);
+  }
+  if((size_t)n == mapsize) {
+    memcpy(T, map, mapsize);
+  } else {
+    piece = (size_t)n / SAMPLE_PIECES;
+    for(i = 0; i < SAMPLE_PIECES; ++i) {
+      memcpy(T + i * piece, (const sauchar_t *)map + i * (mapsize / SAMPLE_PIECES), piece);
+    }
+    n = (saidx_t)(piece * SAMPLE_PIECES);
+  }
+  sa_munmap(map, mapsize);
+  fprintf(stderr, "%s: %" PRIdSAIDX_T " byte sample of `%s'\n", argv[0], n, fname);
+
+  /* Search one parameter at a time, keeping the others at their best, until
+     a pass changes nothing. A candidate must win by 1% to count. */
+  divsufsort_tuning_default(&best);
+  if((defsec = bestsec = measure(T, SA, n, &best, reps)) < 0.0) {
+    fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
+    exit(EXIT_FAILURE);
+  }
+  print_tuning("  default: ", &best, defsec);
+  for(pass = 0, improved = 1; (pass < 3) && (improved != 0); ++pass) {
+    for(k = 0, improved = 0; k < 4; ++k) {
+      for(j = 0; 0 <= candidates[k][j]; ++j) {
+        cur = best;
+        setparam(&cur, k, candidates[k][j]);
+        if(memcmp(&cur, &best, sizeof(cur)) == 0) { continue; }
+        if((sec = measure(T, SA, n, &cur, reps)) < 0.0) {
+          fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
+          exit(EXIT_FAILURE);
+        }
+        if(sec < (bestsec * 0.99)) {
+          best = cur, bestsec = sec, improved = 1;
+          print_tuning("  better:  ", &best, bestsec);
+        }
+      }
+    }
+  }
+
+  /* Check the result and write the profile. */
+  if((divsufsort_tuned(T, SA, n, &best) != 0) || (sufcheck(T, SA, n, 0) != 0)) {
+    fprintf(stderr, "%s: The tuned sort failed its check.\n", argv[0]);
+    exit(EXIT_FAILURE);
+  }
+  if(divsufsort_tuning_save(ofname, &best) != 0) {
+    fprintf(stderr, "%s: Cannot write to `%s': ", argv[0], ofname);
+    perror(NULL);
+    exit(EXIT_FAILURE);
+  }
+  print_tuning("  best:    ", &best, bestsec);
+  fprintf(stderr, "%s: %.1f%% faster than the defaults, written to `%s'\n",
+          argv[0], (defsec - bestsec) * 100.0 / defsec, ofname);
+
+  free(SA);
+  free(T);
+
+  return 0;
+}
@@ -51,10 +51,29 @@
 # include <fcntl.h>
 #endif
 #include <time.h>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
 #include <divsufsort.h>
 #include "lfs.h"
 
 
+/* Returns the wall-clock time in seconds. */
+static
+double
+wallclock(void) {
+#if defined(_OPENMP)
+  return omp_get_wtime();
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#else
+  return (double)time(NULL);
+#endif
+}
+
+
 static
 size_t
 write_int(FILE *fp, saidx_t n) {
@@ -70,36 +89,57 @@ print_help(const char *progname, int status) {
   fprintf(stderr,
           "bwt, a burrows-wheeler transform program, version %s.\n",
           divsufsort_version());
-  fprintf(stderr, "usage: %s [-b num] INFILE OUTFILE\n", progname);
-  fprintf(stderr, "  -b num    set block size to num MiB [1..512] (default: 32)\n\n");
+  fprintf(stderr, "usage: %s [-b num] [-t num] [-x] INFILE OUTFILE\n", progname);
+  fprintf(stderr, "  -b num    set block size to num MiB [1..512] (default: 32)\n");
+  fprintf(stderr, "  -t num    transform num blocks at a time, using 5 * blocksize\n"
+                  "            bytes of memory for each (default: number of cores)\n");
+  fprintf(stderr, "  -x        write a block-indexed file with a checksum per block,\n"
+                  "            whose blocks unbwt can decode independently\n\n");
   exit(status);
 }
 
 int
 main(int argc, const char *argv[]) {
   FILE *fp, *ofp;
+  bwtfile_t *bf;
   const char *fname, *ofname;
   sauchar_t *T;
   saidx_t *SA;
-  LFS_OFF_T n;
+  LFS_OFF_T n, total;
   size_t m;
   saidx_t pidx;
-  clock_t start,finish;
-  saint_t i, blocksize = 32, needclose = 3;
+  double start, finish, t0, t1, t2;
+  double readtime, bwttime, waittime, writetime;
+  double myread, mybwt, mywait, mywrite;
+  saint_t i, blocksize = 32, nthreads = 1, indexed = 0, needclose = 3;
+  saint_t eof, err;
+#ifdef _OPENMP
+  omp_lock_t *turn;
+  long k, nextread;
+#endif
 
   /* Check arguments. */
   if((argc == 1) ||
      (strcmp(argv[1], "-h") == 0) ||
      (strcmp(argv[1], "--help") == 0)) { print_help(argv[0], EXIT_SUCCESS); }
-  if((argc != 3) && (argc != 5)) { print_help(argv[0], EXIT_FAILURE); }
-  i = 1;
-  if(argc == 5) {
-    if(strcmp(argv[i], "-b") != 0) { print_help(argv[0], EXIT_FAILURE); }
-    blocksize = atoi(argv[i + 1]);
-    if(blocksize < 0) { blocksize = 1; }
-    else if(512 < blocksize) { blocksize = 512; }
-    i += 2;
+#ifdef _OPENMP
+  nthreads = omp_get_max_threads();
+#endif
+  for(i = 1; (i < (argc - 2)) && (argv[i][0] == '-'); ++i) {
+    if(strcmp(argv[i], "-x") == 0) {
+      indexed = 1;
+    } else if((argc - 3) <= i) {
+      print_help(argv[0], EXIT_FAILURE);
+    } else if(strcmp(argv[i], "-b") == 0) {
+      blocksize = atoi(argv[++i]);
+      if(blocksize < 0) { blocksize = 1; }
+      else if(512 < blocksize) { blocksize = 512; }
+    } else if(strcmp(argv[i], "-t") == 0) {
+      nthreads = atoi(argv[++i]);
+      if(nthreads < 1) { nthreads = 1; }
+    } else { print_help(argv[0], EXIT_FAILURE); }
   }
+  if(i != (argc - 2)) { print_help(argv[0], EXIT_FAILURE); }
   blocksize <<= 20;
 
   /* Open a file for reading. */
@@ -127,8 +167,18 @@ main(int argc, const char *argv[]) {
   }
   i += 1;
 
-  /* Open a file for writing. */
-  if(strcmp(argv[i], "-") != 0) {
+  /* Open a file for writing. A block-indexed file is created once the
+     block size is known. */
+  bf = NULL;
+  if(indexed != 0) {
+    if(strcmp(argv[i], "-") == 0) {
+      fprintf(stderr, "%s: A block-indexed file cannot be written to stdout.\n", argv[0]);
+      exit(EXIT_FAILURE);
+    }
+    ofp = NULL;
+    ofname = argv[i];
+    needclose ^= 2;
+  } else if(strcmp(argv[i], "-") != 0) {
 #if HAVE_FOPEN_S
     if(fopen_s(&ofp, ofname = argv[i], "wb") != 0) {
 #else
@@ -160,61 +210,161 @@ main(int argc, const char *argv[]) {
       perror(NULL);
       exit(EXIT_FAILURE);
     }
+    if((0 < blocksize) && (((n - 1) / blocksize + 1) < nthreads)) {
+      /* No more threads than blocks. */
+      nthreads = (saint_t)((n - 1) / blocksize + 1);
+    }
     if(0x20000000L < n) { n = 0x20000000L; }
     if((blocksize == 0) || (n < blocksize)) { blocksize = (saidx_t)n; }
   } else if(blocksize == 0) { blocksize = 32 << 20; }
 
-  /* Allocate 5blocksize bytes of memory. */
-  T = (sauchar_t *)malloc(blocksize * sizeof(sauchar_t));
-  SA = (saidx_t *)malloc(blocksize * sizeof(saidx_t));
-  if((T == NULL) || (SA == NULL)) {
-    fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
-    exit(EXIT_FAILURE);
-  }
-
   /* Write the blocksize. */
-  if(write_int(ofp, blocksize) != 4) {
+  if(indexed != 0) {
+    if((bf = bwtfile_create(ofname, blocksize)) == NULL) {
+      fprintf(stderr, "%s: Cannot open file `%s': ", argv[0], ofname);
+      perror(NULL);
+      exit(EXIT_FAILURE);
+    }
+  } else if(write_int(ofp, blocksize) != 4) {
     fprintf(stderr, "%s: Cannot write to `%s': ", argv[0], ofname);
     perror(NULL);
     exit(EXIT_FAILURE);
   }
 
-  fprintf(stderr, "  BWT (blocksize %" PRIdSAINT_T ") ... ", blocksize);
-  start = clock();
-  for(n = 0; 0 < (m = fread(T, sizeof(sauchar_t), blocksize, fp)); n += m) {
-    /* Burrows-Wheeler Transform. */
-    pidx = divbwt(T, T, SA, m);
-    if(pidx < 0) {
-      fprintf(stderr, "%s (bw_transform): %s.\n",
-        argv[0],
-        (pidx == -1) ? "Invalid arguments" : "Cannot allocate memory");
+  /* Each thread reads the next block, transforms it in its own buffers,
+     and writes it once all the blocks before it have been written. The
+     reader of block k holds turn[k % (nthreads + 1)] until it has written
+     it, so the writer of block k + 1 sleeps on that lock instead of
+     spinning. A thread holds one block at a time, so while block k is
+     unwritten no block past k + nthreads - 1 is read, and no lock is
+     taken again before the thread waiting on it has had its turn. */
+#ifdef _OPENMP
+  if((turn = (omp_lock_t *)malloc((nthreads + 1) * sizeof(omp_lock_t))) == NULL) {
+    fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
+    exit(EXIT_FAILURE);
+  }
+  for(i = 0; i <= nthreads; ++i) { omp_init_lock(turn + i); }
+#endif
+  fprintf(stderr, "  BWT (blocksize %" PRIdSAINT_T ", %" PRIdSAINT_T " threads) ... ",
+          blocksize, nthreads);
+  total = 0, eof = 0, err = 0;
+#ifdef _OPENMP
+  nextread = 0;
+#endif
+  readtime = bwttime = waittime = writetime = 0.0;
+  start = wallclock();
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) default(shared) \
+  private(T, SA, m, pidx, k, t0, t1, t2, myread, mybwt, mywait, mywrite)
+#endif
+  {
+    /* Allocate 5blocksize bytes of memory. */
+    T = (sauchar_t *)malloc(blocksize * sizeof(sauchar_t));
+    SA = (saidx_t *)malloc(blocksize * sizeof(saidx_t));
+    if((T == NULL) || (SA == NULL)) {
+      fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
       exit(EXIT_FAILURE);
     }
+    myread = mybwt = mywait = mywrite = 0.0;
 
-    /* Write the bwted data. */
-    if((write_int(ofp, pidx) != 4) ||
-       (fwrite(T, sizeof(sauchar_t), m, ofp) != m)) {
-      fprintf(stderr, "%s: Cannot write to `%s': ", argv[0], ofname);
-      perror(NULL);
-      exit(EXIT_FAILURE);
+    for(;;) {
+      /* Read the next block. */
+      t0 = wallclock();
+#ifdef _OPENMP
+#pragma omp critical(bwt_reader)
+#endif
+      {
+        m = 0;
+        if(eof == 0) {
+          if(0 < (m = fread(T, sizeof(sauchar_t), blocksize, fp))) {
+            total += m;
+#ifdef _OPENMP
+            k = nextread++;
+            omp_set_lock(turn + k % (nthreads + 1));
+#endif
+          } else {
+            eof = 1;
+            if(ferror(fp)) { err = 1; }
+          }
+        }
+      }
+      t1 = wallclock();
+      myread += t1 - t0;
+      if(m == 0) { break; }
+
+      /* Burrows-Wheeler Transform. */
+      pidx = divbwt(T, T, SA, m);
+      if(pidx < 0) {
+        fprintf(stderr, "%s (bw_transform): %s.\n",
+          argv[0],
+          (pidx == -1) ? "Invalid arguments" : "Cannot allocate memory");
+        exit(EXIT_FAILURE);
+      }
+      t2 = wallclock();
+      mybwt += t2 - t1;
+
+      /* Wait for the turn of this block. */
+#ifdef _OPENMP
+      if(0 < k) {
+        omp_set_lock(turn + (k - 1) % (nthreads + 1));
+        omp_unset_lock(turn + (k - 1) % (nthreads + 1));
+      }
+#endif
+      t0 = wallclock();
+      mywait += t0 - t2;
+
+      /* Write the bwted data. */
+      if((bf != NULL) ? (bwtfile_append(bf, T, (saidx_t)m, pidx) != 0) :
+         ((write_int(ofp, pidx) != 4) ||
+          (fwrite(T, sizeof(sauchar_t), m, ofp) != m))) {
+        fprintf(stderr, "%s: Cannot write to `%s': ", argv[0], ofname);
+        perror(NULL);
+        exit(EXIT_FAILURE);
+      }
+#ifdef _OPENMP
+      omp_unset_lock(turn + k % (nthreads + 1));
+#endif
+      mywrite += wallclock() - t0;
+    }
+
+#ifdef _OPENMP
+#pragma omp critical(bwt_stats)
+#endif
+    {
+      readtime += myread, bwttime += mybwt;
+      waittime += mywait, writetime += mywrite;
     }
+
+    /* Deallocate memory. */
+    free(SA);
+    free(T);
   }
-  if(ferror(fp)) {
+  finish = wallclock();
+#ifdef _OPENMP
+  for(i = 0; i <= nthreads; ++i) { omp_destroy_lock(turn + i); }
+  free(turn);
+#endif
+  if(err != 0) {
     fprintf(stderr, "%s: Cannot read from `%s': ", argv[0], fname);
     perror(NULL);
     exit(EXIT_FAILURE);
   }
-  finish = clock();
-  fprintf(stderr, "%" PRIdOFF_T " bytes: %.4f sec\n",
-    n, (double)(finish - start) / (double)CLOCKS_PER_SEC);
+  n = total;
+  fprintf(stderr, "%" PRIdOFF_T " bytes: %.4f sec (%.2f MB/s)\n",
+    n, finish - start,
+    (0.0 < (finish - start)) ? (double)n / (finish - start) / 1e6 : 0.0);
+  fprintf(stderr, "  read %.4f sec, transform %.4f sec, wait %.4f sec, write %.4f sec"
+                  " (summed over threads)\n",
+    readtime, bwttime, waittime, writetime);
 
   /* Close files */
   if(needclose & 1) { fclose(fp); }
   if(needclose & 2) { fclose(ofp); }
-
-  /* Deallocate memory. */
-  free(SA);
-  free(T);
+  if((bf != NULL) && (bwtfile_close(bf) != 0)) {
+    fprintf(stderr, "%s: Cannot write to `%s': ", argv[0], ofname);
+    perror(NULL);
+    exit(EXIT_FAILURE);
+  }
 
   return 0;
 }
@@ -0,0 +1,215 @@
+/*
+ * fmbench.c for libdivsufsort
+ * Copyright (c) 2003-2008 Yuta Mori All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <stdio.h>
+#if HAVE_STRING_H
+# include <string.h>
+#endif
+#if HAVE_STDLIB_H
+# include <stdlib.h>
+#endif
+#if HAVE_MEMORY_H
+# include <memory.h>
+#endif
+#if HAVE_STDDEF_H
+# include <stddef.h>
+#endif
+#if HAVE_STRINGS_H
+# include <strings.h>
+#endif
+#if HAVE_SYS_TYPES_H
+# include <sys/types.h>
+#endif
+#if HAVE_IO_H && HAVE_FCNTL_H
+# include <io.h>
+# include <fcntl.h>
+#endif
+#include <time.h>
+#include <divsufsort.h>
+#include "lfs.h"
+
+
+
+static
+void
+print_help(const char *progname, int status) {
+  fprintf(stderr,
+          "fmbench, an FM-index benchmark, version %s.\n",
+          divsufsort_version());
+  fprintf(stderr, "usage: %s [-s num] [-i num] [-m num] [-q num] FILE\n", progname);
+  fprintf(stderr, "  -s num    set SA sampling interval to num (default: 32)\n");
+  fprintf(stderr, "  -i num    set ISA sampling interval to num (default: 64)\n");
+  fprintf(stderr, "  -m num    set pattern length to num (default: 16)\n");
+  fprintf(stderr, "  -q num    set number of queries to num (default: 100000)\n\n");
+  exit(status);
+}
+
+static
+double
+elapsed(clock_t start) {
+  return (double)(clock() - start) / (double)CLOCKS_PER_SEC;
+}
+
+int
+main(int argc, const char *argv[]) {
+  FILE *fp;
+  const char *fname;
+  sauchar_t *T, *U;
+  saidx_t *SA;
+  fmindex_t *fm;
+  LFS_OFF_T n;
+  clock_t start;
+  double sec;
+  saidx_t i, j, k, m = 16, q = 100000, ssample = 32, isample = 64;
+  saidx_t pidx, idx, total;
+  saint_t a;
+
+  /* Check arguments. */
+  if((argc == 1) ||
+     (strcmp(argv[1], "-h") == 0) ||
+     (strcmp(argv[1], "--help") == 0)) { print_help(argv[0], EXIT_SUCCESS); }
+  for(a = 1; (a + 1) < argc; a += 2) {
+    if(strcmp(argv[a], "-s") == 0) { ssample = atoi(argv[a + 1]); }
+    else if(strcmp(argv[a], "-i") == 0) { isample = atoi(argv[a + 1]); }
+    else if(strcmp(argv[a], "-m") == 0) { m = atoi(argv[a + 1]); }
+    else if(strcmp(argv[a], "-q") == 0) { q = atoi(argv[a + 1]); }
+    else { print_help(argv[0], EXIT_FAILURE); }
+  }
+  if((a + 1 != argc) || (ssample < 1) || (isample < 1) || (m < 1) || (q < 1)) {
+    print_help(argv[0], EXIT_FAILURE);
+  }
+
+  /* Open a file for reading. */
+#if HAVE_FOPEN_S
+  if(fopen_s(&fp, fname = argv[a], "rb") != 0) {
+#else
+  if((fp = LFS_FOPEN(fname = argv[a], "rb")) == NULL) {
+#endif
+    fprintf(stderr, "%s: Cannot open file `%s': ", argv[0], fname);
+    perror(NULL);
+    exit(EXIT_FAILURE);
+  }
+
+  /* Get the file size. */
+  if(LFS_FSEEK(fp, 0, SEEK_END) == 0) {
+    n = LFS_FTELL(fp);
+    rewind(fp);
+    if(n < 0) {
+      fprintf(stderr, "%s: Cannot ftell `%s': ", argv[0], fname);
+      perror(NULL);
+      exit(EXIT_FAILURE);
+    }
+    if(0x7fffffff <= n) {
+      fprintf(stderr, "%s: Input file `%s' is too big.\n", argv[0], fname);
+      exit(EXIT_FAILURE);
+    }
+  } else {
+    fprintf(stderr, "%s: Cannot fseek `%s': ", argv[0], fname);
+    perror(NULL);
+    exit(EXIT_FAILURE);
+  }
+  if((n < 1) || (n < m)) {
+    fprintf(stderr, "%s: Input file `%s' is too small.\n", argv[0], fname);
+    exit(EXIT_FAILURE);
+  }
+
+  /* Allocate 6n bytes of memory. */
+  T = (sauchar_t *)malloc((size_t)n * sizeof(sauchar_t));
+  U = (sauchar_t *)malloc((size_t)n * sizeof(sauchar_t));
+  SA = (saidx_t *)malloc((size_t)n * sizeof(saidx_t));
+  if((T == NULL) || (U == NULL) || (SA == NULL)) {
+    fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
+    exit(EXIT_FAILURE);
+  }
+
+  /* Read n bytes of data. */
+  if(fread(T, sizeof(sauchar_t), (size_t)n, fp) != (size_t)n) {
+    fprintf(stderr, "%s: %s `%s': ",
+      argv[0],
+      (ferror(fp) || !feof(fp)) ? "Cannot read from" : "Unexpected EOF in",
+      fname);
+    perror(NULL);
+    exit(EXIT_FAILURE);
+  }
+  fclose(fp);
+
+  /* Build the FM-index. */
+  fprintf(stderr, "%s: %" PRIdOFF_T " bytes\n", fname, n);
+  start = clock();
+  if((divsufsort(T, SA, (saidx_t)n) != 0) ||
+     (bw_transform(T, U, SA, (saidx_t)n, &pidx) != 0) ||
+     ((fm = fmindex_build(U, (saidx_t)n, pidx, SA, ssample, isample)) == NULL)) {
+    fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
+    exit(EXIT_FAILURE);
+  }
+  fprintf(stderr, "  build:   %.4f sec, %.2f bits/symbol\n",
+          elapsed(start), (double)fmindex_size(fm) * 8.0 / (double)n);
+  free(SA);
+
+  /* Count random substrings of T. */
+  srand(1);
+  start = clock();
+  for(k = 0, total = 0; k < q; ++k) {
+    i = (saidx_t)(((double)rand() / ((double)RAND_MAX + 1.0)) * (double)(n - m + 1));
+    total += fmindex_count(fm, T + i, m, &idx);
+  }
+  sec = elapsed(start);
+  fprintf(stderr, "  count:   %.4f sec, %.0f queries/sec (%" PRIdSAIDX_T " matches)\n",
+          sec, (0 < sec) ? (double)q / sec : 0.0, total);
+
+  /* Locate random rows. */
+  start = clock();
+  for(k = 0, j = 0; k < q; ++k) {
+    i = (saidx_t)(((double)rand() / ((double)RAND_MAX + 1.0)) * (double)n);
+    j ^= fmindex_locate(fm, i);
+  }
+  sec = elapsed(start);
+  fprintf(stderr, "  locate:  %.4f sec, %.0f queries/sec\n",
+          sec, (0 < sec) ? (double)q / sec : 0.0);
+
+  /* Extract random substrings. */
+  start = clock();
+  for(k = 0; k < q; ++k) {
+    i = (saidx_t)(((double)rand() / ((double)RAND_MAX + 1.0)) * (double)(n - m + 1));
+    if(fmindex_extract(fm, i, m, U) != 0) {
+      fprintf(stderr, "%s: Cannot extract.\n", argv[0]);
+      exit(EXIT_FAILURE);
+    }
+  }
+  sec = elapsed(start);
+  fprintf(stderr, "  extract: %.4f sec, %.0f queries/sec\n",
+          sec, (0 < sec) ? (double)q / sec : 0.0);
+
+  /* Deallocate memory. */
+  fmindex_free(fm);
+  free(U);
+  free(T);
+
+  return 0;
+}
@@ -55,13 +55,25 @@
 #include "lfs.h"
 
 
+/* Writes a finished chunk of the suffix array while the rest is built. */
+static
+saint_t
+write_chunk(const saidx_t *SA, saidx_t size, void *arg) {
+  return (fwrite(SA, sizeof(saidx_t), (size_t)size, (FILE *)arg) == (size_t)size) ? 0 : -1;
+}
+
 static
 void
 print_help(const char *progname, int status) {
   fprintf(stderr,
           "mksary, a simple suffix array builder, version %s.\n",
           divsufsort_version());
-  fprintf(stderr, "usage: %s INFILE OUTFILE\n\n", progname);
+  fprintf(stderr, "usage: %s [-i] [-t] [-b depth] [-p step] [-c sample] INFILE OUTFILE\n", progname);
+  fprintf(stderr, "  -i        write an index file instead of a raw suffix array\n");
+  fprintf(stderr, "  -t        store the text in the index file (implies -i)\n");
+  fprintf(stderr, "  -b depth  store a bucket index of depth 1 or 2 (implies -i)\n");
+  fprintf(stderr, "  -p step   store a prefix cache of every step-th suffix (implies -i)\n");
+  fprintf(stderr, "  -c sample write a compressed suffix array sampled every sample positions\n\n");
   exit(status);
 }
 
@@ -70,28 +82,44 @@ main(int argc, const char *argv[]) {
   FILE *fp, *ofp;
   const char *fname, *ofname;
   sauchar_t *T;
+  void *map;
+  size_t mapsize;
   saidx_t *SA;
   LFS_OFF_T n;
   clock_t start, finish;
-  saint_t needclose = 3;
+  csa_t *csa;
+  saidx_t step = 0, sample = 0;
+  saint_t i, err, index = 0, depth = 0, flags = 0, needclose = 3;
 
   /* Check arguments. */
   if((argc == 1) ||
      (strcmp(argv[1], "-h") == 0) ||
      (strcmp(argv[1], "--help") == 0)) { print_help(argv[0], EXIT_SUCCESS); }
-  if(argc != 3) { print_help(argv[0], EXIT_FAILURE); }
+  for(i = 1; (i < (argc - 2)) && (argv[i][0] == '-'); ++i) {
+    if(strcmp(argv[i], "-i") == 0) { index = 1; }
+    else if(strcmp(argv[i], "-t") == 0) { index = 1, flags |= SA_INDEX_TEXT; }
+    else if((strcmp(argv[i], "-b") == 0) && (i < (argc - 3))) {
+      index = 1, depth = atoi(argv[++i]);
+      if((depth < 1) || (2 < depth)) { print_help(argv[0], EXIT_FAILURE); }
+    } else if((strcmp(argv[i], "-p") == 0) && (i < (argc - 3))) {
+      index = 1, step = (saidx_t)atoi(argv[++i]);
+      if(step < 1) { print_help(argv[0], EXIT_FAILURE); }
+    } else if((strcmp(argv[i], "-c") == 0) && (i < (argc - 3))) {
+      sample = (saidx_t)atoi(argv[++i]);
+      if(sample < 1) { print_help(argv[0], EXIT_FAILURE); }
+    } else { print_help(argv[0], EXIT_FAILURE); }
+  }
+  if((i != (argc - 2)) || ((index != 0) && (sample != 0))) { print_help(argv[0], EXIT_FAILURE); }
 
-  /* Open a file for reading. */
-  if(strcmp(argv[1], "-") != 0) {
-#if HAVE_FOPEN_S
-    if(fopen_s(&fp, fname = argv[1], "rb") != 0) {
-#else
-    if((fp = LFS_FOPEN(fname = argv[1], "rb")) == NULL) {
-#endif
-      fprintf(stderr, "%s: Cannot open file `%s': ", argv[0], fname);
+  /* Map a file for reading. */
+  map = NULL, mapsize = 0, fp = NULL;
+  if(strcmp(argv[i], "-") != 0) {
+    if(sa_mmap(fname = argv[i], SA_MMAP_POPULATE, &map, &mapsize) != 0) {
+      fprintf(stderr, "%s: Cannot map file `%s': ", argv[0], fname);
       perror(NULL);
       exit(EXIT_FAILURE);
     }
+    needclose ^= 1;
   } else {
 #if HAVE__SETMODE && HAVE__FILENO
     if(_setmode(_fileno(stdin), _O_BINARY) == -1) {
@@ -106,11 +134,19 @@ main(int argc, const char *argv[]) {
   }
 
   /* Open a file for writing. */
-  if(strcmp(argv[2], "-") != 0) {
+  if((index != 0) || (sample != 0)) {
+    /* The index file is written by name once the suffix array is built. */
+    if(strcmp(ofname = argv[i + 1], "-") == 0) {
+      fprintf(stderr, "%s: Cannot write an index file to stdout.\n", argv[0]);
+      exit(EXIT_FAILURE);
+    }
+    ofp = NULL;
+    needclose ^= 2;
+  } else if(strcmp(argv[i + 1], "-") != 0) {
 #if HAVE_FOPEN_S
-    if(fopen_s(&ofp, ofname = argv[2], "wb") != 0) {
+    if(fopen_s(&ofp, ofname = argv[i + 1], "wb") != 0) {
 #else
-    if((ofp = LFS_FOPEN(ofname = argv[2], "wb")) == NULL) {
+    if((ofp = LFS_FOPEN(ofname = argv[i + 1], "wb")) == NULL) {
 #endif
       fprintf(stderr, "%s: Cannot open file `%s': ", argv[0], ofname);
       perror(NULL);
@@ -130,7 +166,13 @@ main(int argc, const char *argv[]) {
   }
 
   /* Get the file size. */
-  if(LFS_FSEEK(fp, 0, SEEK_END) == 0) {
+  if(fp == NULL) {
+    n = (LFS_OFF_T)mapsize;
+    if(0x7fffffff <= n) {
+      fprintf(stderr, "%s: Input file `%s' is too big.\n", argv[0], fname);
+      exit(EXIT_FAILURE);
+    }
+  } else if(LFS_FSEEK(fp, 0, SEEK_END) == 0) {
     n = LFS_FTELL(fp);
     rewind(fp);
     if(n < 0) {
@@ -148,8 +190,8 @@ main(int argc, const char *argv[]) {
     exit(EXIT_FAILURE);
   }
 
-  /* Allocate 5blocksize bytes of memory. */
-  T = (sauchar_t *)malloc((size_t)n * sizeof(sauchar_t));
+  /* Allocate 4n or 5n bytes of memory. */
+  T = (map != NULL) ? (sauchar_t *)map : (sauchar_t *)malloc((size_t)n * sizeof(sauchar_t));
   SA = (saidx_t *)malloc((size_t)n * sizeof(saidx_t));
   if((T == NULL) || (SA == NULL)) {
     fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
@@ -157,7 +199,7 @@ main(int argc, const char *argv[]) {
   }
 
   /* Read n bytes of data. */
-  if(fread(T, sizeof(sauchar_t), (size_t)n, fp) != (size_t)n) {
+  if((fp != NULL) && (fread(T, sizeof(sauchar_t), (size_t)n, fp) != (size_t)n)) {
     fprintf(stderr, "%s: %s `%s': ",
       argv[0],
       (ferror(fp) || !feof(fp)) ? "Cannot read from" : "Unexpected EOF in",
@@ -167,10 +209,17 @@ main(int argc, const char *argv[]) {
   }
   if(needclose & 1) { fclose(fp); }
 
-  /* Construct the suffix array. */
+  /* Construct the suffix array. A raw suffix array is written out
+     while it is being built. */
   fprintf(stderr, "%s: %" PRIdOFF_T " bytes ... ", fname, n);
   start = clock();
-  if(divsufsort(T, SA, (saidx_t)n) != 0) {
+  err = (ofp != NULL) ? divsufsort_sink(T, SA, (saidx_t)n, write_chunk, ofp) :
+                        divsufsort(T, SA, (saidx_t)n);
+  if(err == -3) {
+    fprintf(stderr, "%s: Cannot write to `%s': ", argv[0], ofname);
+    perror(NULL);
+    exit(EXIT_FAILURE);
+  } else if(err != 0) {
     fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
     exit(EXIT_FAILURE);
   }
@@ -178,16 +227,33 @@ main(int argc, const char *argv[]) {
   fprintf(stderr, "%.4f sec\n", (double)(finish - start) / (double)CLOCKS_PER_SEC);
 
   /* Write the suffix array. */
-  if(fwrite(SA, sizeof(saidx_t), (size_t)n, ofp) != (size_t)n) {
+  if(sample != 0) {
+    if((csa = csa_build(T, SA, (saidx_t)n, sample)) == NULL) {
+      fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
+      exit(EXIT_FAILURE);
+    }
+    if(csa_write(csa, ofname) != 0) {
+      fprintf(stderr, "%s: Cannot write to `%s': ", argv[0], ofname);
+      perror(NULL);
+      exit(EXIT_FAILURE);
+    }
+    csa_free(csa);
+  } else if(index != 0) {
+    if(sa_index_write(ofname, T, SA, (saidx_t)n, NULL, depth, step, flags) != 0) {
+      fprintf(stderr, "%s: Cannot write to `%s': ", argv[0], ofname);
+      perror(NULL);
+      exit(EXIT_FAILURE);
+    }
+  }
+  if((needclose & 2) && (fclose(ofp) != 0)) {
     fprintf(stderr, "%s: Cannot write to `%s': ", argv[0], ofname);
     perror(NULL);
     exit(EXIT_FAILURE);
   }
-  if(needclose & 2) { fclose(ofp); }
 
   /* Deallocate memory. */
   free(SA);
-  free(T);
+  if(map != NULL) { sa_munmap(map, mapsize); } else { free(T); }
 
   return 0;
 }
@@ -51,7 +51,6 @@
 # include <fcntl.h>
 #endif
 #include <divsufsort.h>
-#include "lfs.h"
 
 
 static
@@ -66,13 +65,15 @@ print_help(const char *progname, int status) {
 
 int
 main(int argc, const char *argv[]) {
-  FILE *fp;
+  saindex_t index;
+  csa_t *csa;
   const char *P;
-  sauchar_t *T;
-  saidx_t *SA;
-  LFS_OFF_T n;
+  const saidx_t *SA;
+  void *T, *raw;
+  size_t n, rawsize;
   size_t Psize;
   saidx_t i, size, left;
+  saint_t err;
 
   if((argc == 1) ||
      (strcmp(argv[1], "-h") == 0) ||
@@ -82,84 +83,79 @@ main(int argc, const char *argv[]) {
   P = argv[1];
   Psize = strlen(P);
 
-  /* Open a file for reading. */
-#if HAVE_FOPEN_S
-  if(fopen_s(&fp, argv[2], "rb") != 0) {
-#else
-  if((fp = LFS_FOPEN(argv[2], "rb")) == NULL) {
-#endif
-    fprintf(stderr, "%s: Cannot open file `%s': ", argv[0], argv[2]);
+  /* Map the text and the suffix array. A search touches only a few pages
+     of each, so they are neither read nor prefaulted. */
+  if(sa_mmap(argv[2], SA_MMAP_RANDOM, &T, &n) != 0) {
+    fprintf(stderr, "%s: Cannot map file `%s': ", argv[0], argv[2]);
     perror(NULL);
     exit(EXIT_FAILURE);
   }
-
-  /* Get the file size. */
-  if(LFS_FSEEK(fp, 0, SEEK_END) == 0) {
-    n = LFS_FTELL(fp);
-    rewind(fp);
-    if(n < 0) {
-      fprintf(stderr, "%s: Cannot ftell `%s': ", argv[0], argv[2]);
-      perror(NULL);
+  if(((saidx_t)n < 0) || ((size_t)(saidx_t)n != n)) {
+    fprintf(stderr, "%s: Input file `%s' is too big.\n", argv[0], argv[2]);
+    exit(EXIT_FAILURE);
+  }
+  raw = NULL, rawsize = 0, csa = NULL, SA = NULL;
+  if((err = sa_index_load(argv[3], SA_MMAP_RANDOM, &index)) == 0) {
+    /* An index file written by mksary -i. */
+    if(index.n != (saidx_t)n) {
+      fprintf(stderr, "%s: `%s' is not an index of `%s'.\n",
+              argv[0], argv[3], argv[2]);
+      exit(EXIT_FAILURE);
+    }
+    SA = index.SA;
+  } else if((err == -3) &&
+             ((csa = csa_load(argv[3], SA_MMAP_RANDOM)) != NULL)) {
+    /* A compressed suffix array written by mksary -c. */
+    if((csa_lookup(csa, (saidx_t)n - 1) < 0) || (0 <= csa_lookup(csa, (saidx_t)n))) {
+      fprintf(stderr, "%s: `%s' is not the suffix array of `%s'.\n",
+              argv[0], argv[3], argv[2]);
+      exit(EXIT_FAILURE);
+    }
+  } else if((err == -3) &&
+            (sa_mmap(argv[3], SA_MMAP_RANDOM, &raw, &rawsize) == 0)) {
+    /* A raw suffix array. */
+    if(rawsize != n * sizeof(saidx_t)) {
+      fprintf(stderr, "%s: `%s' is not the suffix array of `%s'.\n",
+              argv[0], argv[3], argv[2]);
       exit(EXIT_FAILURE);
     }
+    SA = (const saidx_t *)raw;
   } else {
-    fprintf(stderr, "%s: Cannot fseek `%s': ", argv[0], argv[2]);
+    fprintf(stderr, "%s: Cannot map file `%s': ", argv[0], argv[3]);
     perror(NULL);
     exit(EXIT_FAILURE);
   }
 
-  /* Allocate 5n bytes of memory. */
-  T = (sauchar_t *)malloc((size_t)n * sizeof(sauchar_t));
-  SA = (saidx_t *)malloc((size_t)n * sizeof(saidx_t));
-  if((T == NULL) || (SA == NULL)) {
-    fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
-    exit(EXIT_FAILURE);
-  }
-
-  /* Read n bytes of data. */
-  if(fread(T, sizeof(sauchar_t), (size_t)n, fp) != (size_t)n) {
-    fprintf(stderr, "%s: %s `%s': ",
-      argv[0],
-      (ferror(fp) || !feof(fp)) ? "Cannot read from" : "Unexpected EOF in",
-      argv[2]);
-    perror(NULL);
-    exit(EXIT_FAILURE);
-  }
-  fclose(fp);
-
-  /* Open the SA file for reading. */
-#if HAVE_FOPEN_S
-  if(fopen_s(&fp, argv[3], "rb") != 0) {
-#else
-  if((fp = LFS_FOPEN(argv[3], "rb")) == NULL) {
-#endif
-    fprintf(stderr, "%s: Cannot open file `%s': ", argv[0], argv[3]);
-    perror(NULL);
-    exit(EXIT_FAILURE);
-  }
-
-  /* Read n * sizeof(saidx_t) bytes of data. */
-  if(fread(SA, sizeof(saidx_t), (size_t)n, fp) != (size_t)n) {
-    fprintf(stderr, "%s: %s `%s': ",
-      argv[0],
-      (ferror(fp) || !feof(fp)) ? "Cannot read from" : "Unexpected EOF in",
-      argv[3]);
-    perror(NULL);
-    exit(EXIT_FAILURE);
-  }
-  fclose(fp);
-
   /* Search and print */
-  size = sa_search(T, (saidx_t)n,
-                   (const sauchar_t *)P, (saidx_t)Psize,
-                   SA, (saidx_t)n, &left);
+  if(n == 0) { return 0; }
+  if(csa != NULL) {
+    size = csa_search(csa, (const sauchar_t *)P, (saidx_t)Psize, &left);
+    for(i = 0; i < size; ++i) {
+      fprintf(stdout, "%" PRIdSAIDX_T "\n", csa_lookup(csa, left + i));
+    }
+    csa_free(csa);
+    sa_munmap(T, n);
+    return 0;
+  } else if(raw == NULL) {
+    size = (index.B != NULL) ?
+      sa_search_bucketindex((const sauchar_t *)T, (saidx_t)n,
+                            (const sauchar_t *)P, (saidx_t)Psize,
+                            SA, (saidx_t)n, index.B, index.depth, &left) :
+      sa_search((const sauchar_t *)T, (saidx_t)n,
+                (const sauchar_t *)P, (saidx_t)Psize,
+                SA, (saidx_t)n, &left);
+  } else {
+    size = sa_search((const sauchar_t *)T, (saidx_t)n,
+                     (const sauchar_t *)P, (saidx_t)Psize,
+                     SA, (saidx_t)n, &left);
+  }
   for(i = 0; i < size; ++i) {
     fprintf(stdout, "%" PRIdSAIDX_T "\n", SA[left + i]);
   }
 
-  /* Deallocate memory. */
-  free(SA);
-  free(T);
+  /* Unmap the files. */
+  if(raw == NULL) { sa_index_close(&index); } else { sa_munmap(raw, rawsize); }
+  sa_munmap(T, n);
 
   return 0;
 }
@@ -61,7 +61,8 @@ print_help(const char *progname, int status) {
   fprintf(stderr,
           "suftest, a suffixsort tester, version %s.\n",
           divsufsort_version());
-  fprintf(stderr, "usage: %s FILE\n\n", progname);
+  fprintf(stderr, "usage: %s [-v] FILE\n", progname);
+  fprintf(stderr, "  -v        print the phase times and counters of the sort\n\n");
   exit(status);
 }
 
@@ -70,28 +71,31 @@ main(int argc, const char *argv[]) {
   FILE *fp;
   const char *fname;
   sauchar_t *T;
+  void *map;
+  size_t mapsize;
   saidx_t *SA;
   LFS_OFF_T n;
   clock_t start, finish;
-  saint_t needclose = 1;
+  divsufsort_stats_t stats;
+  saint_t i, needclose = 1, verbose = 0;
 
   /* Check arguments. */
   if((argc == 1) ||
      (strcmp(argv[1], "-h") == 0) ||
      (strcmp(argv[1], "--help") == 0)) { print_help(argv[0], EXIT_SUCCESS); }
-  if(argc != 2) { print_help(argv[0], EXIT_FAILURE); }
+  if((argc == 3) && (strcmp(argv[1], "-v") == 0)) { verbose = 1; }
+  else if(argc != 2) { print_help(argv[0], EXIT_FAILURE); }
+  fname = argv[argc - 1];
 
-  /* Open a file for reading. */
-  if(strcmp(argv[1], "-") != 0) {
-#if HAVE_FOPEN_S
-    if(fopen_s(&fp, fname = argv[1], "rb") != 0) {
-#else
-    if((fp = LFS_FOPEN(fname = argv[1], "rb")) == NULL) {
-#endif
-      fprintf(stderr, "%s: Cannot open file `%s': ", argv[0], fname);
+  /* Map a file for reading. */
+  map = NULL, mapsize = 0, fp = NULL;
+  if(strcmp(fname, "-") != 0) {
+    if(sa_mmap(fname, SA_MMAP_POPULATE, &map, &mapsize) != 0) {
+      fprintf(stderr, "%s: Cannot map file `%s': ", argv[0], fname);
       perror(NULL);
       exit(EXIT_FAILURE);
     }
+    needclose ^= 1;
   } else {
 #if HAVE__SETMODE && HAVE__FILENO
     if(_setmode(_fileno(stdin), _O_BINARY) == -1) {
@@ -106,7 +110,13 @@ main(int argc, const char *argv[]) {
   }
 
   /* Get the file size. */
-  if(LFS_FSEEK(fp, 0, SEEK_END) == 0) {
+  if(fp == NULL) {
+    n = (LFS_OFF_T)mapsize;
+    if(0x7fffffff <= n) {
+      fprintf(stderr, "%s: Input file `%s' is too big.\n", argv[0], fname);
+      exit(EXIT_FAILURE);
+    }
+  } else if(LFS_FSEEK(fp, 0, SEEK_END) == 0) {
     n = LFS_FTELL(fp);
     rewind(fp);
     if(n < 0) {
@@ -124,8 +134,8 @@ main(int argc, const char *argv[]) {
     exit(EXIT_FAILURE);
   }
 
-  /* Allocate 5n bytes of memory. */
-  T = (sauchar_t *)malloc((size_t)n * sizeof(sauchar_t));
+  /* Allocate 4n or 5n bytes of memory. */
+  T = (map != NULL) ? (sauchar_t *)map : (sauchar_t *)malloc((size_t)n * sizeof(sauchar_t));
   SA = (saidx_t *)malloc((size_t)n * sizeof(saidx_t));
   if((T == NULL) || (SA == NULL)) {
     fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
@@ -133,11 +143,11 @@ main(int argc, const char *argv[]) {
   }
 
   /* Read n bytes of data. */
-  if(fread(T, sizeof(sauchar_t), (size_t)n, fp) != (size_t)n) {
+  if((fp != NULL) && (fread(T, sizeof(sauchar_t), (size_t)n, fp) != (size_t)n)) {
     fprintf(stderr, "%s: %s `%s': ",
       argv[0],
       (ferror(fp) || !feof(fp)) ? "Cannot read from" : "Unexpected EOF in",
-      argv[1]);
+      fname);
     perror(NULL);
     exit(EXIT_FAILURE);
   }
@@ -146,19 +156,36 @@ main(int argc, const char *argv[]) {
   /* Construct the suffix array. */
   fprintf(stderr, "%s: %" PRIdOFF_T " bytes ... ", fname, n);
   start = clock();
-  if(divsufsort(T, SA, (saidx_t)n) != 0) {
+  if(divsufsort_stats(T, SA, (saidx_t)n, (verbose != 0) ? &stats : NULL) != 0) {
     fprintf(stderr, "%s: Cannot allocate memory.\n", argv[0]);
     exit(EXIT_FAILURE);
   }
   finish = clock();
   fprintf(stderr, "%.4f sec\n", (double)(finish - start) / (double)CLOCKS_PER_SEC);
+  if(verbose != 0) {
+    fprintf(stderr, "  B* suffixes:  %" PRIdSAIDX_T "\n", stats.m);
+    fprintf(stderr, "  count:        %.4f sec\n", stats.time_count);
+    fprintf(stderr, "  sssort:       %.4f sec, %" PRIdSAIDX_T " in-place merges,"
+                    " %" PRIdSAIDX_T " buckets on all threads\n",
+            stats.time_sssort, stats.ss_inplacemerges, stats.ss_parallel_buckets);
+    fprintf(stderr, "  rank:         %.4f sec\n", stats.time_rank);
+    fprintf(stderr, "  trsort:       %.4f sec, %" PRIdSAIDX_T " iterations,"
+                    " budget exhausted %" PRIdSAIDX_T " times\n",
+            stats.time_trsort, stats.tr_iterations, stats.tr_budget_exhausted);
+    fprintf(stderr, "  induce:       %.4f sec\n", stats.time_induce);
+    fprintf(stderr, "  buckets per thread:");
+    for(i = 0; (i < stats.nthreads) && (i < DIVSUFSORT_STATS_MAXTHREADS); ++i) {
+      fprintf(stderr, " %" PRIdSAIDX_T, stats.buckets[i]);
+    }
+    fprintf(stderr, "\n");
+  }
 
   /* Check the suffix array. */
   if(sufcheck(T, SA, (saidx_t)n, 1) != 0) { exit(EXIT_FAILURE); }
 
   /* Deallocate memory. */
   free(SA);
-  free(T);
+  if(map != NULL) { sa_munmap(map, mapsize); } else { free(T); }
 
   return 0;
 }
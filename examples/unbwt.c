@@ -51,10 +51,28 @@
 # include <fcntl.h>
 #endif
 #include <time.h>
+#ifdef _OPENMP
+# include <omp.h>
+#endif
 #include <divsufsort.h>
 #include "lfs.h"
 
 
+/* Returns the wall-clock time in seconds. */
+static
+double
+wallclock(void) {
+#if defined(_OPENMP)
+  return omp_get_wtime();
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#else
+  return (double)time(NULL);
+#endif
+}
+
 static
 size_t
 read_int(FILE *fp, saidx_t *n) {
@@ -73,34 +91,128 @@ print_help(const char *progname, int status) {
   fprintf(stderr,
           "unbwt, an inverse burrows-wheeler transform program, version %s.\n",
           divsufsort_version());
-  fprintf(stderr, "usage: %s INFILE OUTFILE\n\n", progname);
+  fprintf(stderr, "usage: %s [-t num] [-k num] [-c] INFILE OUTFILE\n", progname);
+  fprintf(stderr, "options for a block-indexed file (bwt -x):\n");
+  fprintf(stderr, "  -t num    decode num blocks at a time (default: number of cores)\n");
+  fprintf(stderr, "  -k num    decode only block num\n");
+  fprintf(stderr, "  -c        verify the checksums of the blocks without decoding\n\n");
   exit(status);
 }
 
+/* Decodes blocks first..last-1 of a block-indexed file. Each thread
+   verifies and decodes blocks in its own buffers; the blocks are written
+   in order. */
+static
+LFS_OFF_T
+unbwt_indexed(const char *progname, const bwtfile_t *bf,
+              saidx_t first, saidx_t last, saint_t checkonly, saint_t nthreads,
+              FILE *ofp, const char *ofname) {
+  sauchar_t *T;
+  saidx_t *A;
+  saidx_t k, blocksize, m;
+  LFS_OFF_T n = 0;
+  saint_t failed = 0;
+
+  blocksize = bwtfile_blocksize(bf);
+  if((0 < (last - first)) && ((last - first) < nthreads)) { nthreads = (saint_t)(last - first); }
+  if(blocksize < 1) { blocksize = 1; }
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) default(shared) private(T, A, k, m)
+#endif
+  {
+    T = NULL, A = NULL;
+    if(checkonly == 0) {
+      /* Allocate 5blocksize bytes of memory. */
+      T = (sauchar_t *)malloc(blocksize * sizeof(sauchar_t));
+      A = (saidx_t *)malloc(blocksize * sizeof(saidx_t));
+      if((T == NULL) || (A == NULL)) {
+        fprintf(stderr, "%s: Cannot allocate memory.\n", progname);
+        exit(EXIT_FAILURE);
+      }
+    }
+
+#ifdef _OPENMP
+#pragma omp for ordered schedule(dynamic, 1)
+#endif
+    for(k = first; k < last; ++k) {
+      m = (checkonly != 0) ? bwtfile_verify(bf, k) : bwtfile_decode(bf, k, T, A);
+#ifdef _OPENMP
+#pragma omp ordered
+#endif
+      {
+        if(m < 0) {
+          fprintf(stderr, "%s: Block %" PRIdSAIDX_T " %s.\n",
+            progname, k,
+            (m == -3) ? "is corrupt" : (m == -2) ? "cannot be decoded: out of memory" :
+                                                   "cannot be decoded");
+          if(checkonly == 0) { exit(EXIT_FAILURE); }
+          failed = 1;
+        } else if(checkonly == 0) {
+          /* Write m bytes of data. */
+          if(fwrite(T, sizeof(sauchar_t), (size_t)m, ofp) != (size_t)m) {
+            fprintf(stderr, "%s: Cannot write to `%s': ", progname, ofname);
+            perror(NULL);
+            exit(EXIT_FAILURE);
+          }
+          n += m;
+        }
+      }
+    }
+
+    /* Deallocate memory. */
+    free(A);
+    free(T);
+  }
+  return (failed == 0) ? n : -1;
+}
+
 int
 main(int argc, const char *argv[]) {
   FILE *fp, *ofp;
+  bwtfile_t *bf;
   const char *fname, *ofname;
   sauchar_t *T;
   saidx_t *A;
   LFS_OFF_T n;
   size_t m;
-  saidx_t pidx;
-  clock_t start, finish;
-  saint_t err, blocksize, needclose = 3;
+  saidx_t pidx, block = -1;
+  double start, finish;
+  saint_t i, err, blocksize, nthreads = 1, checkonly = 0, needclose = 3;
 
   /* Check arguments. */
   if((argc == 1) ||
      (strcmp(argv[1], "-h") == 0) ||
      (strcmp(argv[1], "--help") == 0)) { print_help(argv[0], EXIT_SUCCESS); }
-  if(argc != 3) { print_help(argv[0], EXIT_FAILURE); }
+#ifdef _OPENMP
+  nthreads = omp_get_max_threads();
+#endif
+  for(i = 1; (i < (argc - 2)) && (argv[i][0] == '-'); ++i) {
+    if(strcmp(argv[i], "-c") == 0) {
+      checkonly = 1;
+    } else if((argc - 3) <= i) {
+      print_help(argv[0], EXIT_FAILURE);
+    } else if(strcmp(argv[i], "-t") == 0) {
+      nthreads = atoi(argv[++i]);
+      if(nthreads < 1) { nthreads = 1; }
+    } else if(strcmp(argv[i], "-k") == 0) {
+      block = (saidx_t)atol(argv[++i]);
+      if(block < 0) { print_help(argv[0], EXIT_FAILURE); }
+    } else { print_help(argv[0], EXIT_FAILURE); }
+  }
+  if(i != (argc - 2)) { print_help(argv[0], EXIT_FAILURE); }
 
-  /* Open a file for reading. */
-  if(strcmp(argv[1], "-") != 0) {
+  /* Open a file for reading. A block-indexed file is mapped rather than
+     read, and anything bwtfile_open does not take is a plain one. */
+  fname = argv[i];
+  bf = (strcmp(fname, "-") != 0) ? bwtfile_open(fname) : NULL;
+  if(bf != NULL) {
+    fp = NULL;
+    needclose ^= 1;
+  } else if(strcmp(argv[i], "-") != 0) {
 #if HAVE_FOPEN_S
-    if(fopen_s(&fp, fname = argv[1], "rb") != 0) {
+    if(fopen_s(&fp, fname = argv[i], "rb") != 0) {
 #else
-    if((fp = LFS_FOPEN(fname = argv[1], "rb")) == NULL) {
+    if((fp = LFS_FOPEN(fname = argv[i], "rb")) == NULL) {
 #endif
       fprintf(stderr, "%s: Cannot open file `%s': ", argv[0], fname);
       perror(NULL);
@@ -118,13 +230,22 @@ main(int argc, const char *argv[]) {
     fname = "stdin";
     needclose ^= 1;
   }
+  if((bf == NULL) && ((checkonly != 0) || (0 <= block))) {
+    fprintf(stderr, "%s: `%s' is not a block-indexed file.\n", argv[0], fname);
+    exit(EXIT_FAILURE);
+  }
+  i += 1;
 
   /* Open a file for writing. */
-  if(strcmp(argv[2], "-") != 0) {
+  if(checkonly != 0) {
+    ofp = NULL;
+    ofname = argv[i];
+    needclose ^= 2;
+  } else if(strcmp(argv[i], "-") != 0) {
 #if HAVE_FOPEN_S
-    if(fopen_s(&ofp, ofname = argv[2], "wb") != 0) {
+    if(fopen_s(&ofp, ofname = argv[i], "wb") != 0) {
 #else
-    if((ofp = LFS_FOPEN(ofname = argv[2], "wb")) == NULL) {
+    if((ofp = LFS_FOPEN(ofname = argv[i], "wb")) == NULL) {
 #endif
       fprintf(stderr, "%s: Cannot open file `%s': ", argv[0], ofname);
       perror(NULL);
@@ -143,6 +264,34 @@ main(int argc, const char *argv[]) {
     needclose ^= 2;
   }
 
+  if(bf != NULL) {
+    if(bwtfile_nblocks(bf) <= block) {
+      fprintf(stderr, "%s: `%s' has only %" PRIdSAIDX_T " blocks.\n",
+              argv[0], fname, bwtfile_nblocks(bf));
+      exit(EXIT_FAILURE);
+    }
+    if(checkonly != 0) {
+      fprintf(stderr, "Verify (%" PRIdSAIDX_T " blocks) ... ", bwtfile_nblocks(bf));
+    } else {
+      fprintf(stderr, "UnBWT (blocksize %" PRIdSAIDX_T ", %" PRIdSAINT_T " threads) ... ",
+              bwtfile_blocksize(bf), nthreads);
+    }
+    start = wallclock();
+    n = (block < 0) ?
+      unbwt_indexed(argv[0], bf, 0, bwtfile_nblocks(bf), checkonly, nthreads, ofp, ofname) :
+      unbwt_indexed(argv[0], bf, block, block + 1, checkonly, nthreads, ofp, ofname);
+    finish = wallclock();
+    bwtfile_close(bf);
+    if(n < 0) { exit(EXIT_FAILURE); }
+    if(checkonly != 0) {
+      fprintf(stderr, "OK: %.4f sec\n", finish - start);
+    } else {
+      fprintf(stderr, "%" PRIdOFF_T " bytes: %.4f sec\n", n, finish - start);
+    }
+    if(needclose & 2) { fclose(ofp); }
+    return 0;
+  }
+
   /* Read the blocksize. */
   if(read_int(fp, &blocksize) != 4) {
     fprintf(stderr, "%s: Cannot read from `%s': ", argv[0], fname);
@@ -159,7 +308,7 @@ main(int argc, const char *argv[]) {
   }
 
   fprintf(stderr, "UnBWT (blocksize %" PRIdSAINT_T ") ... ", blocksize);
-  start = clock();
+  start = wallclock();
   for(n = 0; (m = read_int(fp, &pidx)) != 0; n += m) {
     /* Read blocksize bytes of data. */
     if((m != 4) || ((m = fread(T, sizeof(sauchar_t), blocksize, fp)) == 0)) {
@@ -191,9 +340,8 @@ main(int argc, const char *argv[]) {
     perror(NULL);
     exit(EXIT_FAILURE);
   }
-  finish = clock();
-  fprintf(stderr, "%" PRIdOFF_T " bytes: %.4f sec\n",
-    n, (double)(finish - start) / (double)CLOCKS_PER_SEC);
+  finish = wallclock();
+  fprintf(stderr, "%" PRIdOFF_T " bytes: %.4f sec\n", n, finish - start);
 
   /* Close files */
   if(needclose & 1) { fclose(fp); }
@@ -44,6 +44,9 @@ extern "C" {
 #cmakedefine HAVE_MEMORY_H 1
 #cmakedefine HAVE_SYS_TYPES_H 1
 
+/** for mmap **/
+#cmakedefine HAVE_MMAP 1
+
 /** for WinIO **/
 #cmakedefine HAVE_IO_H 1
 #cmakedefine HAVE_FCNTL_H 1
@@ -63,6 +66,10 @@ extern "C" {
 # endif
 #endif
 
+/** for benchmarks **/
+#cmakedefine HAVE_FORK 1
+#cmakedefine HAVE_GETRUSAGE 1
+
 /** for inline **/
 #ifndef INLINE
 # define INLINE @INLINE@
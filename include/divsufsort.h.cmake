@@ -32,6 +32,7 @@ extern "C" {
 #endif /* __cplusplus */
 
 @INCFILE@
+#include <stddef.h>
 
 #ifndef DIVSUFSORT_API
 # ifdef DIVSUFSORT_BUILD_DLL
@@ -54,6 +55,72 @@ typedef @SAINT32_TYPE@ saint_t;
 #define SAIDX@W64BIT@_T
 typedef @SAINDEX_TYPE@ saidx@W64BIT@_t;
 #endif /* SAIDX@W64BIT@_T */
+#ifndef FMINDEX@W64BIT@_T
+#define FMINDEX@W64BIT@_T
+typedef struct _fmindex@W64BIT@_t fmindex@W64BIT@_t;
+#endif /* FMINDEX@W64BIT@_T */
+#ifndef CSA@W64BIT@_T
+#define CSA@W64BIT@_T
+typedef struct _csa@W64BIT@_t csa@W64BIT@_t;
+#endif /* CSA@W64BIT@_T */
+#ifndef BWTFILE@W64BIT@_T
+#define BWTFILE@W64BIT@_T
+typedef struct _bwtfile@W64BIT@_t bwtfile@W64BIT@_t;
+#endif /* BWTFILE@W64BIT@_T */
+#ifndef DIVSUFSORT_TUNING_T
+#define DIVSUFSORT_TUNING_T
+/* Runtime parameters of the sort, see divsufsort_tuned. */
+typedef struct _divsufsort_tuning_t divsufsort_tuning_t;
+struct _divsufsort_tuning_t {
+  saint_t ss_blocksize;               /* 0 to sort each bucket as one block */
+  saint_t ss_insertionsort_threshold; /* substring groups sorted directly */
+  saint_t tr_insertionsort_threshold; /* rank groups sorted directly */
+  saint_t tr_budget_num;              /* trsort starts with */
+  saint_t tr_budget_den;              /*   ilg(m) * num / den chances */
+  /* ss_blocksize is at most 32767, the thresholds 256 and num and den 65536. */
+};
+#endif /* DIVSUFSORT_TUNING_T */
+#ifndef DIVSUFSORT_STATS@W64BIT@_T
+#define DIVSUFSORT_STATS@W64BIT@_T
+#ifndef DIVSUFSORT_STATS_MAXTHREADS
+#define DIVSUFSORT_STATS_MAXTHREADS (64)
+#endif /* DIVSUFSORT_STATS_MAXTHREADS */
+/* What one sort did and where its time went, see divsufsort_stats. */
+typedef struct _divsufsort_stats@W64BIT@_t divsufsort_stats@W64BIT@_t;
+struct _divsufsort_stats@W64BIT@_t {
+  saidx@W64BIT@_t n;                   /* length of the string */
+  saidx@W64BIT@_t m;                   /* number of type B* suffixes */
+  double time_count;           /* wall-clock seconds of the counting pass, */
+  double time_sssort;          /*   the substring sort, */
+  double time_rank;            /*   the rank computation, */
+  double time_trsort;          /*   the tandem repeat sort */
+  double time_induce;          /*   and the induction */
+  saidx@W64BIT@_t tr_iterations;       /* trsort doubling iterations */
+  saidx@W64BIT@_t tr_budget_exhausted; /* times the trsort budget ran out */
+  saidx@W64BIT@_t ss_inplacemerges;    /* merges without a large enough buffer */
+  saidx@W64BIT@_t ss_parallel_buckets; /* buckets sorted by all threads at once */
+  saint_t nthreads;            /* threads of the bucket loop */
+  saidx@W64BIT@_t buckets[DIVSUFSORT_STATS_MAXTHREADS]; /* buckets per thread */
+};
+#endif /* DIVSUFSORT_STATS@W64BIT@_T */
+#ifndef SAINDEX@W64BIT@_T
+#define SAINDEX@W64BIT@_T
+/* An index file mapped by sa_index_load. The arrays point into the
+   mapping; those not stored in the file are NULL. */
+typedef struct _saindex@W64BIT@_t saindex@W64BIT@_t;
+struct _saindex@W64BIT@_t {
+  void *map;
+  size_t mapsize;
+  saidx@W64BIT@_t n;
+  const sauchar_t *T;
+  const saidx@W64BIT@_t *SA;
+  const saidx@W64BIT@_t *LCP;
+  const saidx@W64BIT@_t *B;
+  saint_t depth;
+  const sauchar_t *PC;
+  saidx@W64BIT@_t step;
+};
+#endif /* SAINDEX@W64BIT@_T */
 #ifndef PRIdSAINT_T
 #define PRIdSAINT_T @SAINT_PRId@
 #endif /* PRIdSAINT_T */
@@ -61,6 +128,25 @@ typedef @SAINDEX_TYPE@ saidx@W64BIT@_t;
 #define PRIdSAIDX@W64BIT@_T @SAINDEX_PRId@
 #endif /* PRIdSAIDX@W64BIT@_T */
 
+/*- Constants -*/
+#ifndef SA_PREFIXCACHE_WIDTH
+#define SA_PREFIXCACHE_WIDTH (8)
+#define SA_PREFIXCACHE_SIZE(_n, _step) \
+  ((0 < (_n)) ? ((((_n) - 1) / (_step)) + 1) * SA_PREFIXCACHE_WIDTH : 0)
+#endif /* SA_PREFIXCACHE_WIDTH */
+#ifndef SA_BUCKETINDEX_SIZE
+#define SA_BUCKETINDEX_SIZE(_depth) (((_depth) == 1) ? 257 : (256 * 257 + 1))
+#endif /* SA_BUCKETINDEX_SIZE */
+#ifndef SA_MMAP_POPULATE
+#define SA_MMAP_POPULATE (1)
+#define SA_MMAP_RANDOM (2)
+#define SA_MMAP_SEQUENTIAL (4)
+#endif /* SA_MMAP_POPULATE */
+#ifndef SA_INDEX_TEXT
+#define SA_INDEX_TEXT (8)
+#define SA_INDEX_VERIFY (16)
+#endif /* SA_INDEX_TEXT */
+
 
 /*- Prototypes -*/
 
@@ -75,6 +161,25 @@ DIVSUFSORT_API
 saint_t
 divsufsort@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t *SA, saidx@W64BIT@_t n);
 
+/**
+ * Constructs the suffix array of a given string and hands it to a sink
+ * while it is being built.
+ * The final scan completes SA from left to right; each chunk is passed to
+ * sink as soon as it is final, so that writing it out overlaps with the
+ * rest of the construction. The chunks are consecutive and cover SA.
+ * @param T[0..n-1] The input string.
+ * @param SA[0..n-1] The output array of suffixes.
+ * @param n The length of the given string.
+ * @param sink The callback, which returns 0 to continue. (can be NULL)
+ * @param arg The argument passed to sink.
+ * @return 0 if no error occurred, -3 if sink failed, -1 or -2 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+divsufsort_sink@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t *SA, saidx@W64BIT@_t n,
+                saint_t (*sink)(const saidx@W64BIT@_t *SA, saidx@W64BIT@_t size, void *arg),
+                void *arg);
+
 /**
  * Constructs the burrows-wheeler transformed string of a given string.
  * @param T[0..n-1] The input string.
@@ -87,6 +192,118 @@ DIVSUFSORT_API
 saidx@W64BIT@_t
 divbwt@W64BIT@(const sauchar_t *T, sauchar_t *U, saidx@W64BIT@_t *A, saidx@W64BIT@_t n);
 
+/**
+ * Constructs the suffix array and the burrows-wheeler transformed string
+ * of a given string in one pass.
+ * U is filled in from each chunk of SA as soon as the final scan has
+ * finished it, instead of being derived by a second sort or pass.
+ * @param T[0..n-1] The input string.
+ * @param SA[0..n-1] The output array of suffixes.
+ * @param U[0..n-1] The output string. (cannot be T)
+ * @param n The length of the given string.
+ * @return The primary index if no error occurred, -1 or -2 otherwise.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+divsufsort_bwt@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t *SA,
+               sauchar_t *U, saidx@W64BIT@_t n);
+
+/**
+ * Constructs the suffix array of a given string with given sort parameters.
+ * The result is the same as that of divsufsort; only the speed depends on
+ * the parameters, which can be searched on sample data by the autotune
+ * tool and kept in a profile.
+ * @param T[0..n-1] The input string.
+ * @param SA[0..n-1] The output array of suffixes.
+ * @param n The length of the given string.
+ * @param tuning The sort parameters. (NULL for the defaults)
+ * @return 0 if no error occurred, -1 or -2 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+divsufsort_tuned@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t *SA, saidx@W64BIT@_t n,
+                 const divsufsort_tuning_t *tuning);
+
+/**
+ * Sets the sort parameters the library was built with.
+ * @param tuning The output parameters.
+ */
+DIVSUFSORT_API
+void
+divsufsort_tuning_default@W64BIT@(divsufsort_tuning_t *tuning);
+
+/**
+ * Reads the sort parameters from a profile written by divsufsort_tuning_save.
+ * Parameters missing from the profile keep their default values.
+ * @param filename The name of the profile.
+ * @param tuning The output parameters.
+ * @return 0 if no error occurred, -1 on a read error,
+ *         -3 if the file is not a valid profile.
+ */
+DIVSUFSORT_API
+saint_t
+divsufsort_tuning_load@W64BIT@(const char *filename, divsufsort_tuning_t *tuning);
+
+/**
+ * Writes the sort parameters to a profile.
+ * The profile is a text file of "name value" lines.
+ * @param filename The name of the profile.
+ * @param tuning The parameters.
+ * @return 0 if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+divsufsort_tuning_save@W64BIT@(const char *filename, const divsufsort_tuning_t *tuning);
+
+/**
+ * Constructs the suffix array of a given string, reporting its progress.
+ * progress is called about every million suffixes of work from the
+ * counting pass, the substring sort, each trsort pass and the final scans,
+ * with the estimated fraction of the sort completed so far. It may be
+ * called from any thread, but never from two at once. Returning nonzero
+ * from it cancels the sort, which then returns as soon as its threads
+ * notice, leaving SA undefined.
+ * @param T[0..n-1] The input string.
+ * @param SA[0..n-1] The output array of suffixes.
+ * @param n The length of the given string.
+ * @param progress The callback, which returns 0 to continue. (can be NULL)
+ * @param arg The argument passed to progress.
+ * @return 0 if no error occurred, -4 if cancelled, -1 or -2 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+divsufsort_progress@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t *SA, saidx@W64BIT@_t n,
+                    saint_t (*progress)(double fraction, void *arg),
+                    void *arg);
+
+/**
+ * Constructs the suffix array of a given string and reports how.
+ * @param T[0..n-1] The input string.
+ * @param SA[0..n-1] The output array of suffixes.
+ * @param n The length of the given string.
+ * @param stats The output statistics. (can be NULL)
+ * @return 0 if no error occurred, -1 or -2 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+divsufsort_stats@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t *SA, saidx@W64BIT@_t n,
+                 divsufsort_stats@W64BIT@_t *stats);
+
+/**
+ * Constructs the burrows-wheeler transformed string of a given string
+ * and reports how.
+ * @param T[0..n-1] The input string.
+ * @param U[0..n-1] The output string. (can be T)
+ * @param A[0..n-1] The temporary array. (can be NULL)
+ * @param n The length of the given string.
+ * @param stats The output statistics. (can be NULL)
+ * @return The primary index if no error occurred, -1 or -2 otherwise.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+divbwt_stats@W64BIT@(const sauchar_t *T, sauchar_t *U, saidx@W64BIT@_t *A, saidx@W64BIT@_t n,
+             divsufsort_stats@W64BIT@_t *stats);
+
 /**
  * Returns the version of the divsufsort library.
  * @return The version number string.
@@ -138,8 +355,24 @@ DIVSUFSORT_API
 saint_t
 sufcheck@W64BIT@(const sauchar_t *T, const saidx@W64BIT@_t *SA, saidx@W64BIT@_t n, saint_t verbose);
 
+/**
+ * Updates the suffix array of a string after text has been appended to it.
+ * Only the suffixes of the new text, and those old ones whose order the new
+ * text can change, are sorted; they are then merged into the old array.
+ * @param T[0..N-1] The string after appending.
+ * @param SA[0..N-1] The suffix array of T[0..n-1] on input, of T[0..N-1] on output.
+ * @param n The length of the string before appending.
+ * @param N The length of the string after appending.
+ * @return 0 if no error occurred, -1 or -2 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+sa_append@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t *SA,
+          saidx@W64BIT@_t n, saidx@W64BIT@_t N);
+
 /**
  * Search for the pattern P in the string T.
+ * See sa_search_bucketindex for a variant that starts from a bucket index.
  * @param T[0..Tsize-1] The input string.
  * @param Tsize The length of the given string.
  * @param P[0..Psize-1] The input pattern string.
@@ -158,6 +391,8 @@ sa_search@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t Tsize,
 
 /**
  * Search for the character c in the string T.
+ * This binary-searches SA; see sa_simplesearch_bucketindex for a
+ * constant-time lookup in a bucket index.
  * @param T[0..Tsize-1] The input string.
  * @param Tsize The length of the given string.
  * @param SA[0..SAsize-1] The input suffix array.
@@ -172,6 +407,504 @@ sa_simplesearch@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t Tsize,
                 const saidx@W64BIT@_t *SA, saidx@W64BIT@_t SAsize,
                 saint_t c, saidx@W64BIT@_t *left);
 
+/**
+ * Search for multiple patterns in the string T at once.
+ * The binary searches of a group of patterns run in lockstep with their
+ * SA and T probes prefetched, so that the memory latency of one search
+ * is hidden behind the others.
+ * @param T[0..Tsize-1] The input string.
+ * @param Tsize The length of the given string.
+ * @param P[0..Pcount-1] The input pattern strings.
+ * @param Psize[0..Pcount-1] The lengths of the given pattern strings.
+ * @param Pcount The number of patterns.
+ * @param SA[0..SAsize-1] The input suffix array.
+ * @param SAsize The length of the given suffix array.
+ * @param count[0..Pcount-1] The output counts of matches. (-1 for an invalid pattern)
+ * @param idx[0..Pcount-1] The output indexes. (can be NULL)
+ * @param presort Process the patterns in lexicographic order if nonzero.
+ * @return 0 if no error occurred, -1 or -2 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+sa_search_batch@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t Tsize,
+                const sauchar_t * const *P, const saidx@W64BIT@_t *Psize,
+                saidx@W64BIT@_t Pcount,
+                const saidx@W64BIT@_t *SA, saidx@W64BIT@_t SAsize,
+                saidx@W64BIT@_t *count, saidx@W64BIT@_t *idx /* can NULL */,
+                saint_t presort);
+
+/**
+ * Builds the prefix cache of a given suffix array.
+ * The cache holds the first SA_PREFIXCACHE_WIDTH bytes (zero-padded) of
+ * every step-th suffix of SA, stored contiguously.
+ * @param T[0..Tsize-1] The input string.
+ * @param Tsize The length of the given string.
+ * @param SA[0..SAsize-1] The input suffix array.
+ * @param SAsize The length of the given suffix array.
+ * @param step The sampling interval of the cache. (1 for every suffix)
+ * @param PC[0..SA_PREFIXCACHE_SIZE(SAsize, step)-1] The output prefix cache.
+ * @return 0 if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+sa_prefixcache@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t Tsize,
+               const saidx@W64BIT@_t *SA, saidx@W64BIT@_t SAsize,
+               saidx@W64BIT@_t step, sauchar_t *PC);
+
+/**
+ * Search for the pattern P in the string T by using a prefix cache.
+ * Most of the binary search is resolved from the cache alone; T and SA
+ * are touched only to settle the boundaries between two samples.
+ * @param T[0..Tsize-1] The input string.
+ * @param Tsize The length of the given string.
+ * @param P[0..Psize-1] The input pattern string.
+ * @param Psize The length of the given pattern string.
+ * @param SA[0..SAsize-1] The input suffix array.
+ * @param SAsize The length of the given suffix array.
+ * @param PC The prefix cache built by sa_prefixcache.
+ * @param step The sampling interval of the cache.
+ * @param idx The output index.
+ * @return The count of matches if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+sa_search_prefixcache@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t Tsize,
+                      const sauchar_t *P, saidx@W64BIT@_t Psize,
+                      const saidx@W64BIT@_t *SA, saidx@W64BIT@_t SAsize,
+                      const sauchar_t *PC, saidx@W64BIT@_t step,
+                      saidx@W64BIT@_t *idx);
+
+/**
+ * Returns the positions of a suffix array interval sorted by text position.
+ * @param SA[0..SAsize-1] The input suffix array.
+ * @param SAsize The length of the given suffix array.
+ * @param idx The start of the interval. (e.g. from sa_search)
+ * @param count The length of the interval.
+ * @param pos[0..k-1] The output positions in ascending order.
+ * @param k The maximum number of positions to return. (count for all)
+ * @param parallel Use multiple threads for large intervals if nonzero.
+ * @return The number of positions if no error occurred, -1 or -2 otherwise.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+sa_locate@W64BIT@(const saidx@W64BIT@_t *SA, saidx@W64BIT@_t SAsize,
+          saidx@W64BIT@_t idx, saidx@W64BIT@_t count,
+          saidx@W64BIT@_t *pos, saidx@W64BIT@_t k, saint_t parallel);
+
+/**
+ * Builds the bucket index of a given string.
+ * For depth 1, B[c] is the start of the suffixes beginning with c in the
+ * suffix array and B[256] is n. For depth 2, each character c0 owns the
+ * 257 entries from B[c0 * 257]; the first one is the start of the bucket
+ * of c0 and entry 1 + c1 is the start of the suffixes beginning with c0c1.
+ * @param T[0..n-1] The input string.
+ * @param n The length of the given string.
+ * @param B[0..SA_BUCKETINDEX_SIZE(depth)-1] The output bucket index.
+ * @param depth The number of characters indexed. (1 or 2)
+ * @return 0 if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+sa_bucketindex@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t n,
+               saidx@W64BIT@_t *B, saint_t depth);
+
+/**
+ * Search for the pattern P in the string T by using a bucket index.
+ * Patterns of up to depth characters are answered from the index alone.
+ * @param T[0..Tsize-1] The input string.
+ * @param Tsize The length of the given string.
+ * @param P[0..Psize-1] The input pattern string.
+ * @param Psize The length of the given pattern string.
+ * @param SA[0..SAsize-1] The suffix array of T. (SAsize must equal Tsize)
+ * @param SAsize The length of the given suffix array.
+ * @param B The bucket index built by sa_bucketindex.
+ * @param depth The depth of the bucket index.
+ * @param idx The output index.
+ * @return The count of matches if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+sa_search_bucketindex@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t Tsize,
+                      const sauchar_t *P, saidx@W64BIT@_t Psize,
+                      const saidx@W64BIT@_t *SA, saidx@W64BIT@_t SAsize,
+                      const saidx@W64BIT@_t *B, saint_t depth,
+                      saidx@W64BIT@_t *idx);
+
+/**
+ * Search for the character c by using a bucket index.
+ * The interval is read from the index in constant time.
+ * @param B The bucket index built by sa_bucketindex.
+ * @param depth The depth of the bucket index.
+ * @param c The input character.
+ * @param idx The output index.
+ * @return The count of matches if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+sa_simplesearch_bucketindex@W64BIT@(const saidx@W64BIT@_t *B, saint_t depth,
+                            saint_t c, saidx@W64BIT@_t *idx);
+
+/**
+ * Count the suffixes of the string T between the patterns P1 and P2.
+ * The range starts at the first suffix not less than P1 and ends after the
+ * last suffix not greater than P2 or starting with P2, so that P1 == P2
+ * gives the same interval as sa_search. Both bounds are found in a single
+ * binary search that splits only where they part.
+ * @param T[0..Tsize-1] The input string.
+ * @param Tsize The length of the given string.
+ * @param P1[0..P1size-1] The lower pattern string.
+ * @param P1size The length of the lower pattern string.
+ * @param P2[0..P2size-1] The upper pattern string.
+ * @param P2size The length of the upper pattern string.
+ * @param SA[0..SAsize-1] The input suffix array.
+ * @param SAsize The length of the given suffix array.
+ * @param idx The output index of the first suffix of the range.
+ * @return The count of suffixes in the range if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+sa_range@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t Tsize,
+         const sauchar_t *P1, saidx@W64BIT@_t P1size,
+         const sauchar_t *P2, saidx@W64BIT@_t P2size,
+         const saidx@W64BIT@_t *SA, saidx@W64BIT@_t SAsize,
+         saidx@W64BIT@_t *idx);
+
+/**
+ * Count the suffixes of the string T between multiple pairs of patterns.
+ * @param T[0..Tsize-1] The input string.
+ * @param Tsize The length of the given string.
+ * @param P1[0..Rcount-1] The lower pattern strings.
+ * @param P1size[0..Rcount-1] The lengths of the lower pattern strings.
+ * @param P2[0..Rcount-1] The upper pattern strings.
+ * @param P2size[0..Rcount-1] The lengths of the upper pattern strings.
+ * @param Rcount The number of ranges.
+ * @param SA[0..SAsize-1] The input suffix array.
+ * @param SAsize The length of the given suffix array.
+ * @param count[0..Rcount-1] The output counts. (-1 for an invalid range)
+ * @param idx[0..Rcount-1] The output indexes. (can be NULL)
+ * @return 0 if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+sa_range_batch@W64BIT@(const sauchar_t *T, saidx@W64BIT@_t Tsize,
+               const sauchar_t * const *P1, const saidx@W64BIT@_t *P1size,
+               const sauchar_t * const *P2, const saidx@W64BIT@_t *P2size,
+               saidx@W64BIT@_t Rcount,
+               const saidx@W64BIT@_t *SA, saidx@W64BIT@_t SAsize,
+               saidx@W64BIT@_t *count, saidx@W64BIT@_t *idx /* can NULL */);
+
+/**
+ * Maps a file into memory for reading.
+ * Where mmap is not available the file is read into a malloc'd buffer.
+ * @param filename The name of the file.
+ * @param flags SA_MMAP_POPULATE to prefault the pages, SA_MMAP_RANDOM or
+ *              SA_MMAP_SEQUENTIAL to hint the access pattern.
+ * @param addr The output address. (NULL for an empty file)
+ * @param size The output size in bytes.
+ * @return 0 if no error occurred, -1 or -2 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+sa_mmap@W64BIT@(const char *filename, saint_t flags, void **addr, size_t *size);
+
+/**
+ * Unmaps a file mapped by sa_mmap.
+ * @param addr The address returned by sa_mmap.
+ * @param size The size returned by sa_mmap.
+ * @return 0 if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+sa_munmap@W64BIT@(void *addr, size_t size);
+
+/**
+ * Writes an index file.
+ * The file holds a versioned header recording the index width, the text
+ * length and the CRC-32C of the text, followed by the suffix array and the
+ * optional sections, each starting on a 4096-byte boundary.
+ * @param filename The name of the output file.
+ * @param T[0..n-1] The input string.
+ * @param SA[0..n-1] The suffix array of T.
+ * @param n The length of the given string.
+ * @param LCP[0..n-1] The LCP array to store. (can be NULL)
+ * @param depth The depth of the bucket index to store. (0 for none)
+ * @param step The sampling interval of the prefix cache to store. (0 for none)
+ * @param flags SA_INDEX_TEXT to store T as well.
+ * @return 0 if no error occurred, -1 or -2 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+sa_index_write@W64BIT@(const char *filename,
+               const sauchar_t *T, const saidx@W64BIT@_t *SA, saidx@W64BIT@_t n,
+               const saidx@W64BIT@_t *LCP, saint_t depth, saidx@W64BIT@_t step,
+               saint_t flags);
+
+/**
+ * Maps an index file written by sa_index_write.
+ * @param filename The name of the index file.
+ * @param flags SA_MMAP_* hints, and SA_INDEX_VERIFY to check the checksum
+ *              of a stored text.
+ * @param index The output index.
+ * @return 0 if no error occurred, -1 or -2 on a read error,
+ *         -3 if the file is not a valid index for this library.
+ */
+DIVSUFSORT_API
+saint_t
+sa_index_load@W64BIT@(const char *filename, saint_t flags, saindex@W64BIT@_t *index);
+
+/**
+ * Checks that an index was built from a given string.
+ * @param index The index loaded by sa_index_load.
+ * @param T[0..n-1] The input string.
+ * @param n The length of the given string.
+ * @return 0 if the length and the checksum match, -1 or -3 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+sa_index_verify@W64BIT@(const saindex@W64BIT@_t *index, const sauchar_t *T, saidx@W64BIT@_t n);
+
+/**
+ * Unmaps an index loaded by sa_index_load.
+ * @param index The index.
+ */
+DIVSUFSORT_API
+void
+sa_index_close@W64BIT@(saindex@W64BIT@_t *index);
+
+/**
+ * Builds the compressed suffix array of a string.
+ * The Psi function is stored as an Elias-Fano sequence and SA is sampled,
+ * so that SA[i] takes at most sample - 1 steps of Psi to recover.
+ * @param T[0..n-1] The input string.
+ * @param SA[0..n-1] The suffix array of T. (the output of divsufsort)
+ * @param n The length of the given string.
+ * @param sample The sampling interval of SA, in text positions.
+ * @return The compressed suffix array if no error occurred, NULL otherwise.
+ */
+DIVSUFSORT_API
+csa@W64BIT@_t *
+csa_build@W64BIT@(const sauchar_t *T, const saidx@W64BIT@_t *SA, saidx@W64BIT@_t n,
+          saidx@W64BIT@_t sample);
+
+/**
+ * Maps a compressed suffix array written by csa_write.
+ * The header and each section carry a CRC-32C, which is checked here.
+ * @param filename The name of the file.
+ * @param flags SA_MMAP_* hints.
+ * @return The compressed suffix array if no error occurred, NULL otherwise.
+ */
+DIVSUFSORT_API
+csa@W64BIT@_t *
+csa_load@W64BIT@(const char *filename, saint_t flags);
+
+/**
+ * Writes a compressed suffix array to a file.
+ * @param csa The compressed suffix array.
+ * @param filename The name of the output file.
+ * @return 0 if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+csa_write@W64BIT@(const csa@W64BIT@_t *csa, const char *filename);
+
+/**
+ * Deallocates or unmaps a compressed suffix array.
+ * @param csa The compressed suffix array.
+ */
+DIVSUFSORT_API
+void
+csa_free@W64BIT@(csa@W64BIT@_t *csa);
+
+/**
+ * Returns the number of bytes used by a compressed suffix array.
+ * @param csa The compressed suffix array.
+ * @return The size in bytes if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+csa_size@W64BIT@(const csa@W64BIT@_t *csa);
+
+/**
+ * Returns an element of a compressed suffix array.
+ * @param csa The compressed suffix array.
+ * @param i The index.
+ * @return SA[i] if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+csa_lookup@W64BIT@(const csa@W64BIT@_t *csa, saidx@W64BIT@_t i);
+
+/**
+ * Search for the pattern P in a compressed suffix array.
+ * The suffixes are read through Psi, so the text is not needed.
+ * @param csa The compressed suffix array.
+ * @param P[0..Psize-1] The input pattern string.
+ * @param Psize The length of the given pattern string.
+ * @param idx The output index.
+ * @return The count of matches if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+csa_search@W64BIT@(const csa@W64BIT@_t *csa,
+           const sauchar_t *P, saidx@W64BIT@_t Psize, saidx@W64BIT@_t *idx);
+
+/**
+ * Creates a block-indexed BWT file.
+ * Each block carries a CRC-32C, and an index of the blocks is written
+ * by bwtfile_close so that any block can be decoded on its own.
+ * @param filename The output file name.
+ * @param blocksize The maximum length of a block.
+ * @return The file if no error occurred, NULL otherwise.
+ */
+DIVSUFSORT_API
+bwtfile@W64BIT@_t *
+bwtfile_create@W64BIT@(const char *filename, saidx@W64BIT@_t blocksize);
+
+/**
+ * Appends a block to a block-indexed BWT file.
+ * @param bf The file returned by bwtfile_create.
+ * @param U[0..m-1] The BWTed block. (the output of divbwt)
+ * @param m The length of the block.
+ * @param pidx The primary index. (the return value of divbwt)
+ * @return 0 if no error occurred, -1 or -2 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+bwtfile_append@W64BIT@(bwtfile@W64BIT@_t *bf,
+               const sauchar_t *U, saidx@W64BIT@_t m, saidx@W64BIT@_t pidx);
+
+/**
+ * Maps a block-indexed BWT file for reading.
+ * Only the index is checked here; blocks are checked as they are read.
+ * @param filename The input file name.
+ * @return The file if no error occurred, NULL otherwise.
+ */
+DIVSUFSORT_API
+bwtfile@W64BIT@_t *
+bwtfile_open@W64BIT@(const char *filename);
+
+/**
+ * Closes a block-indexed BWT file.
+ * A file opened by bwtfile_create gets its index written first.
+ * @param bf The file. (can be NULL)
+ * @return 0 if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+bwtfile_close@W64BIT@(bwtfile@W64BIT@_t *bf);
+
+/**
+ * Returns the number of blocks of a block-indexed BWT file.
+ * @param bf The file.
+ * @return The number of blocks, -1 on error.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+bwtfile_nblocks@W64BIT@(const bwtfile@W64BIT@_t *bf);
+
+/**
+ * Returns the block size of a block-indexed BWT file.
+ * @param bf The file.
+ * @return The block size, -1 on error.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+bwtfile_blocksize@W64BIT@(const bwtfile@W64BIT@_t *bf);
+
+/**
+ * Verifies the checksum of a block.
+ * @param bf The file returned by bwtfile_open.
+ * @param k The block number.
+ * @return 0 if the block is intact, -3 if it is corrupt, -1 on error.
+ */
+DIVSUFSORT_API
+saint_t
+bwtfile_verify@W64BIT@(const bwtfile@W64BIT@_t *bf, saidx@W64BIT@_t k);
+
+/**
+ * Verifies and decodes a block.
+ * Block k is T[k * blocksize..k * blocksize + m - 1] of the original string.
+ * @param bf The file returned by bwtfile_open.
+ * @param k The block number.
+ * @param T[0..blocksize-1] The output string.
+ * @param A[0..blocksize-1] The temporary array. (can be NULL)
+ * @return The length m of the block if no error occurred,
+ *         -3 if it is corrupt, -1 or -2 otherwise.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+bwtfile_decode@W64BIT@(const bwtfile@W64BIT@_t *bf, saidx@W64BIT@_t k,
+               sauchar_t *T, saidx@W64BIT@_t *A);
+
+/**
+ * Builds the FM-index of a BWTed string.
+ * @param U[0..n-1] The BWTed string. (the output of divbwt)
+ * @param n The length of the given string.
+ * @param pidx The primary index. (the return value of divbwt)
+ * @param SA[0..n-1] The suffix array of the original string. (can be NULL)
+ * @param sasample The sampling interval of SA, in text positions.
+ * @param isasample The sampling interval of the inverse suffix array.
+ * @return The FM-index if no error occurred, NULL otherwise.
+ */
+DIVSUFSORT_API
+fmindex@W64BIT@_t *
+fmindex_build@W64BIT@(const sauchar_t *U, saidx@W64BIT@_t n, saidx@W64BIT@_t pidx,
+              const saidx@W64BIT@_t *SA /* can NULL */,
+              saidx@W64BIT@_t sasample, saidx@W64BIT@_t isasample);
+
+/**
+ * Deallocates an FM-index.
+ * @param fm The FM-index. (can be NULL)
+ */
+DIVSUFSORT_API
+void
+fmindex_free@W64BIT@(fmindex@W64BIT@_t *fm);
+
+/**
+ * Returns the size of an FM-index.
+ * @param fm The FM-index.
+ * @return The number of bytes used by the FM-index, -1 on error.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+fmindex_size@W64BIT@(const fmindex@W64BIT@_t *fm);
+
+/**
+ * Counts the occurrences of the pattern P by backward search.
+ * @param fm The FM-index.
+ * @param P[0..Psize-1] The input pattern string.
+ * @param Psize The length of the given pattern string.
+ * @param idx The output index of the first match in the suffix array.
+ * @return The count of matches if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+fmindex_count@W64BIT@(const fmindex@W64BIT@_t *fm,
+              const sauchar_t *P, saidx@W64BIT@_t Psize, saidx@W64BIT@_t *idx);
+
+/**
+ * Returns the i-th entry of the suffix array.
+ * @param fm The FM-index.
+ * @param i The index into the suffix array. (e.g. from fmindex_count)
+ * @return SA[i] if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saidx@W64BIT@_t
+fmindex_locate@W64BIT@(const fmindex@W64BIT@_t *fm, saidx@W64BIT@_t i);
+
+/**
+ * Extracts a substring of the original string.
+ * @param fm The FM-index.
+ * @param i The start position of the substring.
+ * @param size The length of the substring.
+ * @param U[0..size-1] The output string.
+ * @return 0 if no error occurred, -1 otherwise.
+ */
+DIVSUFSORT_API
+saint_t
+fmindex_extract@W64BIT@(const fmindex@W64BIT@_t *fm,
+                saidx@W64BIT@_t i, saidx@W64BIT@_t size, sauchar_t *U);
+
 
 #ifdef __cplusplus
 } /* extern "C" */
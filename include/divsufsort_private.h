@@ -68,15 +68,84 @@ extern "C" {
 #  define PRIdSAIDX_T PRIdSAIDX64_T
 # endif /* PRIdSAIDX_T */
 # define divsufsort divsufsort64
+# define divsufsort_sink divsufsort_sink64
 # define divbwt divbwt64
+# define divsufsort_bwt divsufsort_bwt64
 # define divsufsort_version divsufsort64_version
 # define bw_transform bw_transform64
 # define inverse_bw_transform inverse_bw_transform64
 # define sufcheck sufcheck64
+# define sa_append sa_append64
+# define divsufsort_tuned divsufsort_tuned64
+# define _divsufsort_stats_t _divsufsort_stats64_t
+# define divsufsort_stats_t divsufsort_stats64_t
+# define divsufsort_stats divsufsort_stats64
+# define divbwt_stats divbwt_stats64
+# define divsufsort_progress divsufsort_progress64
+# define progress_phase progress_phase64
+# define progress_report progress_report64
+# define divsufsort_tuning_default divsufsort_tuning_default64
+# define divsufsort_tuning_load divsufsort_tuning_load64
+# define divsufsort_tuning_save divsufsort_tuning_save64
+# define tuning_check tuning_check64
 # define sa_search sa_search64
 # define sa_simplesearch sa_simplesearch64
+# define sa_search_batch sa_search_batch64
+# define sa_prefixcache sa_prefixcache64
+# define sa_search_prefixcache sa_search_prefixcache64
+# define sa_locate sa_locate64
+# define sa_bucketindex sa_bucketindex64
+# define sa_search_bucketindex sa_search_bucketindex64
+# define sa_simplesearch_bucketindex sa_simplesearch_bucketindex64
+# define sa_range sa_range64
+# define sa_range_batch sa_range_batch64
+# define sa_mmap sa_mmap64
+# define sa_munmap sa_munmap64
+# define _saindex_t _saindex64_t
+# define saindex_t saindex64_t
+# define sa_index_write sa_index_write64
+# define sa_index_load sa_index_load64
+# define sa_index_verify sa_index_verify64
+# define sa_index_close sa_index_close64
+# define _csa_t _csa64_t
+# define csa_t csa64_t
+# define csa_build csa_build64
+# define csa_load csa_load64
+# define csa_write csa_write64
+# define csa_free csa_free64
+# define csa_size csa_size64
+# define csa_lookup csa_lookup64
+# define csa_search csa_search64
+# define _bwtfile_t _bwtfile64_t
+# define bwtfile_t bwtfile64_t
+# define bwtfile_create bwtfile_create64
+# define bwtfile_append bwtfile_append64
+# define bwtfile_open bwtfile_open64
+# define bwtfile_close bwtfile_close64
+# define bwtfile_nblocks bwtfile_nblocks64
+# define bwtfile_blocksize bwtfile_blocksize64
+# define bwtfile_verify bwtfile_verify64
+# define bwtfile_decode bwtfile_decode64
 # define sssort sssort64
+# define ss_isparallel ss_isparallel64
 # define trsort trsort64
+# define sa_test_compares sa_test_compares64
+# define ss_test_mintrosort ss_test_mintrosort64
+# define ss_test_swapmerge ss_test_swapmerge64
+# define ss_test_inplacemerge ss_test_inplacemerge64
+# define tr_test_introsort tr_test_introsort64
+# define tr_test_partition tr_test_partition64
+# define tr_test_copy tr_test_copy64
+# define memlcp memlcp64
+# define crc32c crc32c64
+# define _fmindex_t _fmindex64_t
+# define fmindex_t fmindex64_t
+# define fmindex_build fmindex_build64
+# define fmindex_free fmindex_free64
+# define fmindex_size fmindex_size64
+# define fmindex_count fmindex_count64
+# define fmindex_locate fmindex_locate64
+# define fmindex_extract fmindex_extract64
 #else
 # include "divsufsort.h"
 #endif
@@ -86,6 +155,9 @@ extern "C" {
 #if !defined(UINT8_MAX)
 # define UINT8_MAX (255)
 #endif /* UINT8_MAX */
+#if !defined(SAIDX_MAX)
+# define SAIDX_MAX ((saidx_t)(~(uint64_t)0 >> (65 - 8 * sizeof(saidx_t))))
+#endif /* SAIDX_MAX */
 #if defined(ALPHABET_SIZE) && (ALPHABET_SIZE < 1)
 # undef ALPHABET_SIZE
 #endif
@@ -95,6 +167,18 @@ extern "C" {
 /* for divsufsort.c */
 #define BUCKET_A_SIZE (ALPHABET_SIZE)
 #define BUCKET_B_SIZE (ALPHABET_SIZE * ALPHABET_SIZE)
+#if defined(SA_SINK_CHUNKSIZE)
+# if SA_SINK_CHUNKSIZE < 1
+#  undef SA_SINK_CHUNKSIZE
+#  define SA_SINK_CHUNKSIZE (1)
+# endif
+#else
+# define SA_SINK_CHUNKSIZE (65536)
+#endif
+/* Work, in suffixes, between two calls of a progress callback. */
+#if !defined(SA_PROGRESS_INTERVAL)
+# define SA_PROGRESS_INTERVAL (1 << 20)
+#endif
 /* for sssort.c */
 #if defined(SS_INSERTIONSORT_THRESHOLD)
 # if SS_INSERTIONSORT_THRESHOLD < 1
@@ -104,36 +188,97 @@ extern "C" {
 #else
 # define SS_INSERTIONSORT_THRESHOLD (8)
 #endif
+#define SS_MAXBLOCKSIZE (32767)
 #if defined(SS_BLOCKSIZE)
 # if SS_BLOCKSIZE < 0
 #  undef SS_BLOCKSIZE
 #  define SS_BLOCKSIZE (0)
-# elif 32768 <= SS_BLOCKSIZE
+# elif SS_MAXBLOCKSIZE < SS_BLOCKSIZE
 #  undef SS_BLOCKSIZE
-#  define SS_BLOCKSIZE (32767)
+#  define SS_BLOCKSIZE SS_MAXBLOCKSIZE
 # endif
 #else
 # define SS_BLOCKSIZE (1024)
 #endif
-/* minstacksize = log(SS_BLOCKSIZE) / log(3) * 2 */
-#if SS_BLOCKSIZE == 0
-# if defined(BUILD_DIVSUFSORT64)
-#  define SS_MISORT_STACKSIZE (96)
-# else
-#  define SS_MISORT_STACKSIZE (64)
-# endif
-#elif SS_BLOCKSIZE <= 4096
-# define SS_MISORT_STACKSIZE (16)
+/* The block size is a runtime parameter (0 sorts a bucket as one block),
+   so the stack is sized for a whole bucket. */
+#if defined(BUILD_DIVSUFSORT64)
+# define SS_MISORT_STACKSIZE (96)
 #else
-# define SS_MISORT_STACKSIZE (24)
+# define SS_MISORT_STACKSIZE (64)
 #endif
 #if defined(BUILD_DIVSUFSORT64)
 # define SS_SMERGE_STACKSIZE (64)
 #else
 # define SS_SMERGE_STACKSIZE (32)
 #endif
+#if defined(SS_RADIX_THRESHOLD)
+# if (SS_RADIX_THRESHOLD != 0) && (SS_RADIX_THRESHOLD < (SS_INSERTIONSORT_THRESHOLD + 1))
+#  undef SS_RADIX_THRESHOLD
+#  define SS_RADIX_THRESHOLD (SS_INSERTIONSORT_THRESHOLD + 1)
+# endif
+#else
+# define SS_RADIX_THRESHOLD (256)
+#endif
+#if !defined(SS_RADIX_MAXSIZE)
+# define SS_RADIX_MAXSIZE (4096)
+#endif
+#if !defined(SS_PARALLEL_BLOCKS)
+# define SS_PARALLEL_BLOCKS (64)
+#endif
+/* for utils.c */
+#if defined(SA_BATCH_GROUPSIZE)
+# if SA_BATCH_GROUPSIZE < 1
+#  undef SA_BATCH_GROUPSIZE
+#  define SA_BATCH_GROUPSIZE (1)
+# endif
+#else
+# define SA_BATCH_GROUPSIZE (16)
+#endif
+#if !defined(SA_LOCATE_PARALLEL_THRESHOLD)
+# define SA_LOCATE_PARALLEL_THRESHOLD (65536)
+#endif
+/* for fmindex.c */
+#define FM_SUPERBLOCK_LG (16)
+/* for indexfile.c */
+#define SA_INDEX_MAGIC "DSSAIDX\0"
+#define SA_INDEX_VERSION (1)
+#define SA_INDEX_ALIGN (4096)
+#define SA_INDEX_MAXSECTIONS (8)
+#define SA_INDEX_SECTION_TEXT (1)
+#define SA_INDEX_SECTION_SA (2)
+#define SA_INDEX_SECTION_LCP (3)
+#define SA_INDEX_SECTION_BUCKETINDEX (4)
+#define SA_INDEX_SECTION_PREFIXCACHE (5)
+/* for csa.c */
+#define CSA_MAGIC "DSCSA\0\0\0"
+#define CSA_VERSION (2)
+#define CSA_SELECT_LG (8)
+#define CSA_NSECTIONS (6)
+/* for tuning.c: groups under a threshold are insertion sorted, so a large
+   one makes the sort quadratic. */
+#define TUNING_MAXTHRESHOLD (256)
+#define TUNING_MAXBUDGET (65536)
+/* for bwtfile.c */
+#define BWTFILE_MAGIC "DSBX"
+#define BWTFILE_VERSION (1)
+#define BWTFILE_HEADERSIZE (16)
+#define BWTFILE_ENTRYSIZE (24)
+#define BWTFILE_FOOTERSIZE (24)
 /* for trsort.c */
-#define TR_INSERTIONSORT_THRESHOLD (8)
+#if defined(TR_INSERTIONSORT_THRESHOLD)
+# if TR_INSERTIONSORT_THRESHOLD < 1
+#  undef TR_INSERTIONSORT_THRESHOLD
+#  define TR_INSERTIONSORT_THRESHOLD (1)
+# endif
+#else
+# define TR_INSERTIONSORT_THRESHOLD (8)
+#endif
+/* trsort starts with tr_ilg(n) * TR_BUDGET_NUM / TR_BUDGET_DEN chances. */
+#if !defined(TR_BUDGET_NUM) || !defined(TR_BUDGET_DEN)
+# define TR_BUDGET_NUM (2)
+# define TR_BUDGET_DEN (3)
+#endif
 #if defined(BUILD_DIVSUFSORT64)
 # define TR_STACKSIZE (96)
 #else
@@ -151,6 +296,20 @@ extern "C" {
 #ifndef MAX
 # define MAX(_a, _b) (((_a) > (_b)) ? (_a) : (_b))
 #endif /* MAX */
+#ifndef PREFETCH
+# if defined(__GNUC__)
+#  define PREFETCH(_p) __builtin_prefetch((const void *)(_p))
+# else
+#  define PREFETCH(_p) ((void)(_p))
+# endif
+#endif /* PREFETCH */
+#ifndef SA_HIDDEN
+# if defined(__GNUC__) && (4 <= __GNUC__) && !defined(_WIN32) && !defined(__CYGWIN__)
+#  define SA_HIDDEN __attribute__((visibility("hidden")))
+# else
+#  define SA_HIDDEN
+# endif
+#endif /* SA_HIDDEN */
 #define STACK_PUSH(_a, _b, _c, _d)\
   do {\
     assert(ssize < STACK_SIZE);\
@@ -177,6 +336,34 @@ extern "C" {
     (_a) = stack[--ssize].a, (_b) = stack[ssize].b,\
     (_c) = stack[ssize].c, (_d) = stack[ssize].d, (_e) = stack[ssize].e;\
   } while(0)
+/* for sssort.c and trsort.c */
+#define SORTNET_SIZE (8)
+#define SORTNET8(_cswap)\
+  do {\
+    _cswap(0, 2); _cswap(1, 3); _cswap(4, 6); _cswap(5, 7);\
+    _cswap(0, 4); _cswap(1, 5); _cswap(2, 6); _cswap(3, 7);\
+    _cswap(0, 1); _cswap(2, 3); _cswap(4, 5); _cswap(6, 7);\
+    _cswap(2, 4); _cswap(3, 5); _cswap(1, 4); _cswap(3, 6);\
+    _cswap(1, 2); _cswap(3, 4); _cswap(5, 6);\
+  } while(0)
+/* Counts a key comparison of the sort kernels when they are built with
+   SA_TEST_HOOKS for kernbench, and is just _x otherwise. */
+#if defined(SA_TEST_HOOKS)
+# define SA_COMPARE(_x) (++sa_test_compares, (_x))
+#else
+# define SA_COMPARE(_x) (_x)
+#endif
+/* for compare.c and crc32c.c: the kernel pointers, which threads may race
+   to set to the same value on their first calls. */
+#if defined(__GNUC__)
+# define SA_LOAD_RELAXED(_x) __atomic_load_n(&(_x), __ATOMIC_RELAXED)
+# define SA_STORE_RELAXED(_x, _v) __atomic_store_n(&(_x), (_v), __ATOMIC_RELAXED)
+#else
+# define SA_LOAD_RELAXED(_x) (_x)
+# define SA_STORE_RELAXED(_x, _v) ((_x) = (_v))
+#endif
+/* for utils.c */
+#define BUCKETINDEX2(_c0, _c1) ((_c0) * (ALPHABET_SIZE + 1) + (_c1) + 1)
 /* for divsufsort.c */
 #define BUCKET_A(_c0) bucket_A[(_c0)]
 #if ALPHABET_SIZE == 256
@@ -188,16 +375,80 @@ extern "C" {
 #endif
 
 
+/*- Datatypes -*/
+/* The parameters and the optional instrumentation of one sort. */
+typedef struct _sactx_t sactx_t;
+struct _sactx_t {
+  const divsufsort_tuning_t *tuning;
+  divsufsort_stats_t *stats; /* NULL when nothing is collected */
+  double lap; /* the time the current phase began */
+  saint_t (*progress)(double fraction, void *arg); /* NULL when not reported */
+  void *arg;
+  double lo, hi; /* the fractions at which the current phase begins and ends */
+  saidx_t done, total, reported; /* work of the current phase */
+  double fraction; /* the fraction last passed to progress */
+  volatile saint_t cancelled;
+};
+
+
 /*- Private Prototypes -*/
+/* divsufsort.c */
+void
+progress_phase(sactx_t *ctx, double lo, double hi, saidx_t total);
+saint_t
+progress_report(sactx_t *ctx, saidx_t step);
+/* compare.c */
+SA_HIDDEN saidx_t
+memlcp(const sauchar_t *U1, const sauchar_t *U2, saidx_t n);
+/* crc32c.c */
+SA_HIDDEN uint32_t
+crc32c(uint32_t crc, const void *buf, size_t size);
 /* sssort.c */
 void
 sssort(const sauchar_t *Td, const saidx_t *PA,
        saidx_t *first, saidx_t *last,
        saidx_t *buf, saidx_t bufsize,
-       saidx_t depth, saidx_t n, saint_t lastsuffix);
+       saidx_t depth, saidx_t n, saint_t lastsuffix,
+       sactx_t *ctx);
+#if defined(_OPENMP)
+saint_t
+ss_isparallel(const sactx_t *ctx, saidx_t size, saidx_t bufsize, saint_t nthreads);
+#endif
 /* trsort.c */
 void
-trsort(saidx_t *ISA, saidx_t *SA, saidx_t n, saidx_t depth);
+trsort(saidx_t *ISA, saidx_t *SA, saidx_t n, saidx_t depth,
+       sactx_t *ctx);
+/* tuning.c */
+saint_t
+tuning_check(const divsufsort_tuning_t *tuning);
+#if defined(SA_TEST_HOOKS)
+/* sssort.c and trsort.c, built for kernbench */
+extern uint64_t sa_test_compares;
+void
+ss_test_mintrosort(const sauchar_t *T, const saidx_t *PA,
+                   saidx_t *first, saidx_t *last,
+                   saidx_t depth, saidx_t threshold);
+void
+ss_test_swapmerge(const sauchar_t *T, const saidx_t *PA,
+                  saidx_t *first, saidx_t *middle, saidx_t *last,
+                  saidx_t *buf, saidx_t bufsize, saidx_t depth);
+void
+ss_test_inplacemerge(const sauchar_t *T, const saidx_t *PA,
+                     saidx_t *first, saidx_t *middle, saidx_t *last,
+                     saidx_t depth);
+saidx_t
+tr_test_introsort(saidx_t *ISA, const saidx_t *ISAd,
+                  saidx_t *SA, saidx_t *first, saidx_t *last,
+                  saidx_t threshold);
+void
+tr_test_partition(const saidx_t *ISAd,
+                  saidx_t *first, saidx_t *middle, saidx_t *last,
+                  saidx_t **pa, saidx_t **pb, saidx_t v);
+void
+tr_test_copy(saidx_t *ISA, const saidx_t *SA,
+             saidx_t *first, saidx_t *a, saidx_t *b, saidx_t *last,
+             saidx_t depth);
+#endif /* defined(SA_TEST_HOOKS) */
 
 
 #ifdef __cplusplus
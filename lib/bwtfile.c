@@ -0,0 +1,276 @@
+/*
+ * bwtfile.c for libdivsufsort
+ * Copyright (c) 2003-2008 Yuta Mori All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "divsufsort_private.h"
+
+
+/* A block-indexed BWT file:
+
+     header   "DSBX", version, blocksize, 0              (4 x 4 bytes)
+     block    pidx, m, crc, U[0..m-1]                    (3 x 4 + m bytes)
+     ...
+     index    offset (8), m, pidx, crc, 0                (24 bytes per block)
+     footer   nblocks (8), index offset (8), index crc, "DSBX"
+
+   All integers are little-endian. The crc of a block is the CRC-32C of its
+   pidx and m fields followed by U, and the index crc covers the index.
+   Block k holds the BWT of T[k * blocksize..k * blocksize + m - 1]. */
+struct _bwtfile_t {
+  /* writer */
+  FILE *fp;
+  uint64_t pos;
+  sauchar_t *index;
+  saidx_t nalloc;
+  /* reader */
+  void *map;
+  size_t mapsize;
+  const sauchar_t *entries;
+  /* both */
+  saidx_t blocksize;
+  saidx_t nblocks;
+  saint_t err;
+};
+
+
+/*- Private Functions -*/
+
+static
+void
+_put32(sauchar_t *p, uint32_t x) {
+  p[0] = (sauchar_t)(x & 0xff), p[1] = (sauchar_t)((x >> 8) & 0xff);
+  p[2] = (sauchar_t)((x >> 16) & 0xff), p[3] = (sauchar_t)((x >> 24) & 0xff);
+}
+
+static
+void
+_put64(sauchar_t *p, uint64_t x) {
+  _put32(p, (uint32_t)(x & 0xffffffffU)), _put32(p + 4, (uint32_t)(x >> 32));
+}
+
+static
+uint32_t
+_get32(const sauchar_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+         ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static
+uint64_t
+_get64(const sauchar_t *p) {
+  return (uint64_t)_get32(p) | ((uint64_t)_get32(p + 4) << 32);
+}
+
+static
+saint_t
+_write(bwtfile_t *bf, const void *p, size_t size) {
+  if((bf->err == 0) && (size != 0) && (fwrite(p, 1, size, bf->fp) != size)) { bf->err = -1; }
+  bf->pos += size;
+  return bf->err;
+}
+
+/* Returns the block header at the offset of index entry k, or NULL. */
+static
+const sauchar_t *
+_block(const bwtfile_t *bf, saidx_t k, saidx_t *m, saidx_t *pidx) {
+  const sauchar_t *e, *b;
+  uint64_t offset;
+
+  e = bf->entries + (size_t)k * BWTFILE_ENTRYSIZE;
+  offset = _get64(e), *m = (saidx_t)_get32(e + 8), *pidx = (saidx_t)_get32(e + 12);
+  b = (const sauchar_t *)bf->map + offset;
+  if((offset < BWTFILE_HEADERSIZE) || (*m < 0) || (bf->blocksize < *m) || (*pidx < 0) || (*m < *pidx) ||
+     ((uint64_t)((const sauchar_t *)bf->entries - (const sauchar_t *)bf->map) < offset + 12 + (uint64_t)*m) ||
+     (_get32(b) != (uint32_t)*pidx) || (_get32(b + 4) != (uint32_t)*m) ||
+     (_get32(b + 8) != _get32(e + 16))) { return NULL; }
+  return b;
+}
+
+
+/*---------------------------------------------------------------------------*/
+
+/*- Functions -*/
+
+/* Creates a block-indexed BWT file. */
+bwtfile_t *
+bwtfile_create(const char *filename, saidx_t blocksize) {
+  sauchar_t header[BWTFILE_HEADERSIZE];
+  bwtfile_t *bf;
+
+  if((filename == NULL) || (blocksize < 0) ||
+     ((uint64_t)(uint32_t)blocksize != (uint64_t)blocksize)) { return NULL; }
+  if((bf = (bwtfile_t *)calloc(1, sizeof(bwtfile_t))) == NULL) { return NULL; }
+  if((bf->fp = fopen(filename, "wb")) == NULL) { free(bf); return NULL; }
+  bf->blocksize = blocksize;
+  memcpy(header, BWTFILE_MAGIC, 4);
+  _put32(header + 4, BWTFILE_VERSION);
+  _put32(header + 8, (uint32_t)blocksize);
+  _put32(header + 12, 0);
+  if(_write(bf, header, BWTFILE_HEADERSIZE) != 0) {
+    fclose(bf->fp);
+    free(bf);
+    return NULL;
+  }
+  return bf;
+}
+
+/* Appends a block to a block-indexed BWT file. */
+saint_t
+bwtfile_append(bwtfile_t *bf, const sauchar_t *U, saidx_t m, saidx_t pidx) {
+  sauchar_t header[12], *e;
+  saidx_t nalloc;
+  uint32_t crc;
+
+  if((bf == NULL) || (bf->fp == NULL) || ((U == NULL) && (0 < m)) ||
+     (m < 0) || (bf->blocksize < m) || (pidx < 0) || (m < pidx)) { return -1; }
+  if(bf->err != 0) { return bf->err; }
+  if(bf->nalloc <= bf->nblocks) {
+    nalloc = (bf->nalloc == 0) ? 64 : bf->nalloc * 2;
+    if((e = (sauchar_t *)realloc(bf->index, (size_t)nalloc * BWTFILE_ENTRYSIZE)) == NULL) {
+      return -2;
+    }
+    bf->index = e, bf->nalloc = nalloc;
+  }
+
+  _put32(header, (uint32_t)pidx);
+  _put32(header + 4, (uint32_t)m);
+  crc = crc32c(crc32c(0, header, 8), U, (size_t)m);
+  _put32(header + 8, crc);
+
+  e = bf->index + (size_t)bf->nblocks * BWTFILE_ENTRYSIZE;
+  _put64(e, bf->pos);
+  _put32(e + 8, (uint32_t)m);
+  _put32(e + 12, (uint32_t)pidx);
+  _put32(e + 16, crc);
+  _put32(e + 20, 0);
+  ++bf->nblocks;
+
+  _write(bf, header, 12);
+  return _write(bf, U, (size_t)m);
+}
+
+/* Opens a block-indexed BWT file for reading. */
+bwtfile_t *
+bwtfile_open(const char *filename) {
+  const sauchar_t *p, *footer;
+  bwtfile_t *bf;
+  void *map;
+  size_t mapsize;
+  uint64_t nblocks, offset;
+
+  if(filename == NULL) { return NULL; }
+  if(sa_mmap(filename, SA_MMAP_RANDOM, &map, &mapsize) != 0) { return NULL; }
+  p = (const sauchar_t *)map;
+  footer = p + mapsize - BWTFILE_FOOTERSIZE;
+  if((mapsize < (BWTFILE_HEADERSIZE + BWTFILE_FOOTERSIZE)) ||
+     (memcmp(p, BWTFILE_MAGIC, 4) != 0) || (_get32(p + 4) != BWTFILE_VERSION) ||
+     (memcmp(footer + 20, BWTFILE_MAGIC, 4) != 0)) {
+    sa_munmap(map, mapsize);
+    return NULL;
+  }
+  nblocks = _get64(footer), offset = _get64(footer + 8);
+  if((offset < BWTFILE_HEADERSIZE) || ((uint64_t)(footer - p) < offset) ||
+     (((uint64_t)(footer - p) - offset) != nblocks * BWTFILE_ENTRYSIZE) ||
+     ((uint64_t)(saidx_t)nblocks != nblocks) ||
+     (crc32c(0, p + offset, (size_t)(nblocks * BWTFILE_ENTRYSIZE)) != _get32(footer + 16)) ||
+     ((bf = (bwtfile_t *)calloc(1, sizeof(bwtfile_t))) == NULL)) {
+    sa_munmap(map, mapsize);
+    return NULL;
+  }
+  bf->map = map, bf->mapsize = mapsize;
+  bf->entries = p + offset;
+  bf->blocksize = (saidx_t)_get32(p + 8);
+  bf->nblocks = (saidx_t)nblocks;
+  return bf;
+}
+
+/* Closes a block-indexed BWT file. */
+saint_t
+bwtfile_close(bwtfile_t *bf) {
+  sauchar_t footer[BWTFILE_FOOTERSIZE];
+  uint64_t offset;
+  saint_t err = 0;
+
+  if(bf == NULL) { return -1; }
+  if(bf->fp != NULL) {
+    /* Write the index and the footer. */
+    offset = bf->pos;
+    _write(bf, bf->index, (size_t)bf->nblocks * BWTFILE_ENTRYSIZE);
+    _put64(footer, (uint64_t)bf->nblocks);
+    _put64(footer + 8, offset);
+    _put32(footer + 16, crc32c(0, bf->index, (size_t)bf->nblocks * BWTFILE_ENTRYSIZE));
+    memcpy(footer + 20, BWTFILE_MAGIC, 4);
+    _write(bf, footer, BWTFILE_FOOTERSIZE);
+    err = bf->err;
+    if(fclose(bf->fp) != 0) { err = -1; }
+    free(bf->index);
+  } else {
+    sa_munmap(bf->map, bf->mapsize);
+  }
+  free(bf);
+  return err;
+}
+
+/* Returns the number of blocks of a block-indexed BWT file. */
+saidx_t
+bwtfile_nblocks(const bwtfile_t *bf) {
+  return (bf != NULL) ? bf->nblocks : -1;
+}
+
+/* Returns the block size of a block-indexed BWT file. */
+saidx_t
+bwtfile_blocksize(const bwtfile_t *bf) {
+  return (bf != NULL) ? bf->blocksize : -1;
+}
+
+/* Verifies the checksum of a block. */
+saint_t
+bwtfile_verify(const bwtfile_t *bf, saidx_t k) {
+  const sauchar_t *b;
+  saidx_t m, pidx;
+
+  if((bf == NULL) || (bf->map == NULL) || (k < 0) || (bf->nblocks <= k)) { return -1; }
+  if(((b = _block(bf, k, &m, &pidx)) == NULL) ||
+     (crc32c(crc32c(0, b, 8), b + 12, (size_t)m) != _get32(b + 8))) { return -3; }
+  return 0;
+}
+
+/* Verifies and decodes a block. */
+saidx_t
+bwtfile_decode(const bwtfile_t *bf, saidx_t k, sauchar_t *T, saidx_t *A) {
+  const sauchar_t *b;
+  saidx_t m, pidx;
+  saint_t err;
+
+  if((bf == NULL) || (bf->map == NULL) || (T == NULL) || (k < 0) || (bf->nblocks <= k)) { return -1; }
+  if((err = bwtfile_verify(bf, k)) != 0) { return err; }
+  b = _block(bf, k, &m, &pidx);
+  if(m == 0) { return 0; }
+  if((err = inverse_bw_transform(b + 12, T, A, m, pidx)) != 0) {
+    return (err == -2) ? -2 : -3;
+  }
+  return m;
+}
@@ -0,0 +1,132 @@
+/*
+ * compare.c for libdivsufsort
+ * Copyright (c) 2003-2008 Yuta Mori All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "divsufsort_private.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define MEMLCP_X86 1
+# include <immintrin.h>
+#endif
+
+
+/*- Private Functions -*/
+
+typedef saidx_t (*memlcp_func_t)(const sauchar_t *, const sauchar_t *, saidx_t);
+
+/* Byte-at-a-time kernel. */
+static
+saidx_t
+memlcp_byte(const sauchar_t *U1, const sauchar_t *U2, saidx_t n) {
+  saidx_t i;
+  for(i = 0; (i < n) && (U1[i] == U2[i]); ++i) { }
+  return i;
+}
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && \
+    (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+
+/* Word-at-a-time kernel. */
+static
+saidx_t
+memlcp_word(const sauchar_t *U1, const sauchar_t *U2, saidx_t n) {
+  uint64_t x, y;
+  saidx_t i;
+  for(i = 0; (i + 8) <= n; i += 8) {
+    memcpy(&x, U1 + i, 8), memcpy(&y, U2 + i, 8);
+    if(x != y) { return i + (__builtin_ctzll(x ^ y) >> 3); }
+  }
+  return i + memlcp_byte(U1 + i, U2 + i, n - i);
+}
+
+#else
+# define memlcp_word memlcp_byte
+#endif
+
+#if defined(MEMLCP_X86)
+
+/* SSE2 kernel. */
+__attribute__((target("sse2")))
+static
+saidx_t
+memlcp_sse2(const sauchar_t *U1, const sauchar_t *U2, saidx_t n) {
+  __m128i x, y;
+  unsigned int mask;
+  saidx_t i;
+  for(i = 0; (i + 16) <= n; i += 16) {
+    x = _mm_loadu_si128((const __m128i *)(U1 + i));
+    y = _mm_loadu_si128((const __m128i *)(U2 + i));
+    mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) ^ 0xffffU;
+    if(mask != 0) { return i + __builtin_ctz(mask); }
+  }
+  return i + memlcp_word(U1 + i, U2 + i, n - i);
+}
+
+/* AVX2 kernel. */
+__attribute__((target("avx2")))
+static
+saidx_t
+memlcp_avx2(const sauchar_t *U1, const sauchar_t *U2, saidx_t n) {
+  __m256i x, y;
+  unsigned int mask;
+  saidx_t i;
+  for(i = 0; (i + 32) <= n; i += 32) {
+    x = _mm256_loadu_si256((const __m256i *)(U1 + i));
+    y = _mm256_loadu_si256((const __m256i *)(U2 + i));
+    mask = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+    if(mask != 0) { return i + __builtin_ctz(mask); }
+  }
+  return i + memlcp_sse2(U1 + i, U2 + i, n - i);
+}
+
+#endif /* MEMLCP_X86 */
+
+static saidx_t memlcp_dispatch(const sauchar_t *, const sauchar_t *, saidx_t);
+static memlcp_func_t memlcp_kernel = memlcp_dispatch;
+
+/* Selects the best kernel for the running CPU on the first call. */
+static
+saidx_t
+memlcp_dispatch(const sauchar_t *U1, const sauchar_t *U2, saidx_t n) {
+  memlcp_func_t f = memlcp_word;
+#if defined(MEMLCP_X86)
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2")) { f = memlcp_avx2; }
+  else if(__builtin_cpu_supports("sse2")) { f = memlcp_sse2; }
+#endif
+  SA_STORE_RELAXED(memlcp_kernel, f);
+  return f(U1, U2, n);
+}
+
+
+/*---------------------------------------------------------------------------*/
+
+/*- Function -*/
+
+/* Returns the length of the longest common prefix of U1[0..n-1] and U2[0..n-1]. */
+saidx_t
+memlcp(const sauchar_t *U1, const sauchar_t *U2, saidx_t n) {
+  if(n <= 0) { return 0; }
+  return SA_LOAD_RELAXED(memlcp_kernel)(U1, U2, n);
+}
@@ -0,0 +1,480 @@
+/*
+ * csa.c for libdivsufsort
+ * Copyright (c) 2003-2008 Yuta Mori All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "divsufsort_private.h"
+
+
+/* A compressed suffix array is stored as one contiguous buffer, so that
+   the same layout serves in memory and in a file mapped by csa_load.
+
+   Psi[i] = ISA[SA[i] + 1] increases within the rows of each character,
+   so Psi'[i] = rank(c_i) * 2^lgn + Psi[i], where c_i is the first
+   character of row i, rank() numbers the characters of T densely and
+   2^lgn is the smallest power of two not less than n, increases over the
+   whole array. Psi' is stored as an Elias-Fano sequence, from which
+   both Psi[i] and c_i are read back. SA itself is kept only for the rows
+   whose text position is a multiple of the sampling interval. */
+typedef struct _csaheader_t csaheader_t;
+struct _csaheader_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteorder;
+  uint32_t width;        /* sizeof(saidx_t) */
+  uint32_t sigma;        /* the number of distinct characters */
+  uint32_t lowbits;      /* the number of low bits of each Psi' value */
+  uint32_t lgn;
+  uint64_t n;
+  uint64_t sample;
+  uint64_t lastrow;      /* the row of the last suffix, which has no Psi */
+  uint64_t nsamples;
+  uint64_t size;         /* of the whole buffer, in bytes */
+  uint64_t C[ALPHABET_SIZE + 1];
+  uint64_t low, high, select, marks, markranks, samples; /* offsets */
+  sauchar_t chars[ALPHABET_SIZE];
+  uint32_t crc[CSA_NSECTIONS + 1]; /* CRC-32C of the header and of each section */
+};
+
+struct _csa_t {
+  void *buf;
+  size_t bufsize;
+  saint_t mapped;
+  const csaheader_t *header;
+  const uint64_t *low;
+  const uint64_t *high;
+  const uint64_t *select;   /* the position of every 2^CSA_SELECT_LG-th one */
+  const uint64_t *marks;    /* rows holding an SA sample */
+  const saidx_t *markranks; /* the number of marks before each 512 rows */
+  const saidx_t *samples;
+  saidx_t n, lastrow, sample;
+  saint_t lowbits, lgn;
+};
+
+
+/*- Private Functions -*/
+
+static INLINE
+saint_t
+csa_popcount(uint64_t x) {
+#if defined(__GNUC__) && defined(__POPCNT__)
+  return __builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return (saint_t)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+static INLINE
+saint_t
+csa_ctz(uint64_t x) {
+#if defined(__GNUC__)
+  return __builtin_ctzll(x);
+#else
+  saint_t k;
+  for(k = 0; (x & 1) == 0; x >>= 1, ++k) { }
+  return k;
+#endif
+}
+
+/* Returns Psi'[i]. */
+static INLINE
+uint64_t
+csa_get(const csa_t *csa, saidx_t i) {
+  uint64_t x, lo;
+  size_t pos, w;
+  saint_t j, c, L = csa->lowbits;
+
+  /* The low bits. */
+  lo = 0;
+  if(0 < L) {
+    pos = (size_t)i * L, w = pos >> 6;
+    lo = csa->low[w] >> (pos & 63);
+    if(64 < ((pos & 63) + L)) { lo |= csa->low[w + 1] << (64 - (pos & 63)); }
+    lo &= ((uint64_t)1 << L) - 1;
+  }
+
+  /* The high bits: the position of the i-th one, minus i. */
+  pos = (size_t)csa->select[i >> CSA_SELECT_LG];
+  j = (saint_t)(i & ((1 << CSA_SELECT_LG) - 1));
+  w = pos >> 6;
+  for(x = csa->high[w] & (~(uint64_t)0 << (pos & 63)); j >= (c = csa_popcount(x)); x = csa->high[++w]) {
+    j -= c;
+  }
+  for(; 0 < j; --j) { x &= x - 1; }
+  pos = (w << 6) + (size_t)csa_ctz(x);
+
+  return ((uint64_t)(pos - (size_t)i) << L) | lo;
+}
+
+static INLINE
+saint_t
+csa_ismarked(const csa_t *csa, saidx_t r) {
+  return (saint_t)((csa->marks[r >> 6] >> (r & 63)) & 1);
+}
+
+/* Returns the number of marked rows in [0..r-1]. */
+static INLINE
+saidx_t
+csa_markrank(const csa_t *csa, saidx_t r) {
+  saidx_t w, k;
+  for(w = (r >> 9) << 3, k = csa->markranks[r >> 9]; w < (r >> 6); ++w) {
+    k += csa_popcount(csa->marks[w]);
+  }
+  if((r & 63) != 0) { k += csa_popcount(csa->marks[w] << (64 - (r & 63))); }
+  return k;
+}
+
+/* Compares the pattern P with the suffix of row r, walking Psi instead
+   of reading the text. Returns as _compare in utils.c does. */
+static
+saint_t
+csa_compare(const csa_t *csa, saidx_t r, const sauchar_t *P, saidx_t Psize) {
+  uint64_t x;
+  saidx_t k;
+  saint_t c;
+
+  for(k = 0; k < Psize; ++k) {
+    x = csa_get(csa, r);
+    c = csa->header->chars[x >> csa->lgn];
+    if(c != P[k]) { return c - P[k]; }
+    if(r == csa->lastrow) { return -((k + 1) != Psize); }
+    r = (saidx_t)(x & (((uint64_t)1 << csa->lgn) - 1));
+  }
+
+  return 0;
+}
+
+/* Sets the widths and the layout of the buffer from h->n, h->sigma and
+   h->sample. Returns -1 if n is too large to lay out. */
+static
+saint_t
+csa_layout(csaheader_t *h) {
+  uint64_t n = h->n, nhigh;
+  saint_t L, lgn;
+
+  /* Below 2^52 rows none of the sizes below can overflow. */
+  if((n < 1) || ((n >> 52) != 0) || (h->sigma < 1) || (h->sample < 1)) { return -1; }
+  for(lgn = 0; ((uint64_t)1 << lgn) < n; ++lgn) { }
+  for(L = 0; ((uint64_t)2 << L) <= (((uint64_t)h->sigma << lgn) / n); ++L) { }
+  nhigh = n + ((((uint64_t)h->sigma << lgn) - 1) >> L) + 1;
+
+#define CSA_ALIGN(_x) (((_x) + 63) & ~(uint64_t)63)
+  h->lowbits = (uint32_t)L;
+  h->lgn = (uint32_t)lgn;
+  h->nsamples = (n - 1) / h->sample + 1;
+  h->low = CSA_ALIGN(sizeof(csaheader_t));
+  h->high = h->low + CSA_ALIGN(((n * L) / 64 + 2) * 8);
+  h->select = h->high + CSA_ALIGN((nhigh / 64 + 2) * 8);
+  h->marks = h->select + CSA_ALIGN(((n >> CSA_SELECT_LG) + 1) * 8);
+  h->markranks = h->marks + CSA_ALIGN(((n >> 9) + 1) * 64);
+  h->samples = h->markranks + CSA_ALIGN(((n >> 9) + 1) * sizeof(saidx_t));
+  h->size = h->samples + CSA_ALIGN(h->nsamples * sizeof(saidx_t));
+#undef CSA_ALIGN
+  return 0;
+}
+
+/* Computes the CRC-32C of the header up to crc[], and of each section. */
+static
+void
+csa_checksum(const void *buf, uint32_t *crc) {
+  const sauchar_t *p = (const sauchar_t *)buf;
+  const csaheader_t *h = (const csaheader_t *)buf;
+  uint64_t offset[CSA_NSECTIONS + 1];
+  saint_t k;
+  offset[0] = h->low, offset[1] = h->high, offset[2] = h->select;
+  offset[3] = h->marks, offset[4] = h->markranks, offset[5] = h->samples;
+  offset[6] = h->size;
+  crc[0] = crc32c(0, p, offsetof(csaheader_t, crc));
+  for(k = 0; k < CSA_NSECTIONS; ++k) {
+    crc[k + 1] = crc32c(0, p + offset[k], (size_t)(offset[k + 1] - offset[k]));
+  }
+}
+
+/* Points the arrays of a CSA handle into its buffer. */
+static
+void
+csa_attach(csa_t *csa) {
+  const sauchar_t *p = (const sauchar_t *)csa->buf;
+  const csaheader_t *h = (const csaheader_t *)csa->buf;
+  csa->header = h;
+  csa->low = (const uint64_t *)(p + h->low);
+  csa->high = (const uint64_t *)(p + h->high);
+  csa->select = (const uint64_t *)(p + h->select);
+  csa->marks = (const uint64_t *)(p + h->marks);
+  csa->markranks = (const saidx_t *)(p + h->markranks);
+  csa->samples = (const saidx_t *)(p + h->samples);
+  csa->n = (saidx_t)h->n, csa->lastrow = (saidx_t)h->lastrow;
+  csa->sample = ((uint64_t)(saidx_t)h->sample == h->sample) ? (saidx_t)h->sample : SAIDX_MAX;
+  csa->lowbits = (saint_t)h->lowbits, csa->lgn = (saint_t)h->lgn;
+}
+
+
+/*---------------------------------------------------------------------------*/
+
+/*- Functions -*/
+
+/* Builds the compressed suffix array of a string. */
+csa_t *
+csa_build(const sauchar_t *T, const saidx_t *SA, saidx_t n, saidx_t sample) {
+  saidx_t count[ALPHABET_SIZE], bucket[ALPHABET_SIZE];
+  saint_t rank[ALPHABET_SIZE];
+  csaheader_t header, *h;
+  csa_t *csa;
+  sauchar_t *p;
+  uint64_t *low, *high, *select, *marks;
+  saidx_t *markranks, *samples;
+  uint64_t x, pos, nhigh;
+  saidx_t i, j, r;
+  saint_t c, L, lgn, sigma;
+
+  /* Check arguments. */
+  if((T == NULL) || (SA == NULL) || (n < 1) || (sample < 1)) { return NULL; }
+
+  /* Count the characters and rank the ones that occur. */
+  for(c = 0; c < ALPHABET_SIZE; ++c) { count[c] = 0; }
+  for(i = 0; i < n; ++i) { ++count[T[i]]; }
+  for(c = 0, sigma = 0; c < ALPHABET_SIZE; ++c) {
+    rank[c] = (0 < count[c]) ? sigma++ : -1;
+  }
+
+  /* Lay out the buffer. */
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CSA_MAGIC, 8);
+  header.version = CSA_VERSION;
+  header.byteorder = 0x01020304;
+  header.width = (uint32_t)sizeof(saidx_t);
+  header.sigma = (uint32_t)sigma;
+  header.n = (uint64_t)n;
+  header.sample = (uint64_t)sample;
+  if((csa_layout(&header) != 0) ||
+     ((uint64_t)(size_t)header.size != header.size)) { return NULL; }
+  L = (saint_t)header.lowbits, lgn = (saint_t)header.lgn;
+  nhigh = (uint64_t)n + ((((uint64_t)sigma << lgn) - 1) >> L) + 1;
+  if((csa = (csa_t *)calloc(1, sizeof(csa_t))) == NULL) { return NULL; }
+  if((csa->buf = calloc(1, (size_t)header.size)) == NULL) { free(csa); return NULL; }
+  csa->bufsize = (size_t)header.size;
+  h = (csaheader_t *)csa->buf;
+  memcpy(h, &header, sizeof(header));
+  for(c = 0, i = 0; c < ALPHABET_SIZE; ++c) {
+    h->C[c] = (uint64_t)i;
+    if(0 <= rank[c]) { h->chars[rank[c]] = (sauchar_t)c; }
+    i += count[c];
+  }
+  h->C[ALPHABET_SIZE] = (uint64_t)n;
+  p = (sauchar_t *)csa->buf;
+  low = (uint64_t *)(p + h->low);
+  high = (uint64_t *)(p + h->high);
+  select = (uint64_t *)(p + h->select);
+  marks = (uint64_t *)(p + h->marks);
+  markranks = (saidx_t *)(p + h->markranks);
+  samples = (saidx_t *)(p + h->samples);
+
+  /* Compute Psi by distributing the rows in SA order: the suffix cX sits
+     in the bucket of c, ordered by the row of X. The last suffix is the
+     single character T[n-1], the first of its bucket. */
+  for(c = 0; c < ALPHABET_SIZE; ++c) { bucket[c] = (saidx_t)h->C[c]; }
+  h->lastrow = (uint64_t)bucket[T[n - 1]]++;
+#define CSA_SET(_r, _x)\
+  do {\
+    if(0 < L) {\
+      pos = (uint64_t)(_r) * L;\
+      low[pos >> 6] |= ((_x) & (((uint64_t)1 << L) - 1)) << (pos & 63);\
+      if(64 < ((pos & 63) + L)) {\
+        low[(pos >> 6) + 1] |= ((_x) & (((uint64_t)1 << L) - 1)) >> (64 - (pos & 63));\
+      }\
+    }\
+    pos = ((_x) >> L) + (uint64_t)(_r);\
+    high[pos >> 6] |= (uint64_t)1 << (pos & 63);\
+  } while(0)
+  x = (uint64_t)rank[T[n - 1]] << lgn;
+  CSA_SET(h->lastrow, x);
+  for(j = 0; j < n; ++j) {
+    if(0 < SA[j]) {
+      c = T[SA[j] - 1];
+      r = bucket[c]++;
+      x = ((uint64_t)rank[c] << lgn) + (uint64_t)j;
+      CSA_SET(r, x);
+    }
+    if((SA[j] % sample) == 0) { marks[j >> 6] |= (uint64_t)1 << (j & 63); }
+  }
+#undef CSA_SET
+
+  /* Sample the select positions, the mark ranks and SA. */
+  for(pos = 0, i = 0; pos < nhigh; ++pos) {
+    if((high[pos >> 6] >> (pos & 63)) & 1) {
+      if((i & ((1 << CSA_SELECT_LG) - 1)) == 0) { select[i >> CSA_SELECT_LG] = pos; }
+      ++i;
+    }
+  }
+  for(i = 0, j = 0; i <= (n >> 9); ++i) {
+    markranks[i] = j;
+    for(r = 0; r < 8; ++r) { j += csa_popcount(marks[i * 8 + r]); }
+  }
+  for(j = 0, i = 0; j < n; ++j) {
+    if((SA[j] % sample) == 0) { samples[i++] = SA[j]; }
+  }
+  csa_checksum(csa->buf, h->crc);
+
+  csa_attach(csa);
+  return csa;
+}
+
+/* Maps a compressed suffix array written by csa_write. */
+csa_t *
+csa_load(const char *filename, saint_t flags) {
+  const csaheader_t *h;
+  csaheader_t layout;
+  csa_t *csa;
+  uint32_t crc[CSA_NSECTIONS + 1];
+  void *map;
+  size_t mapsize;
+  uint64_t n;
+  saint_t c;
+
+  if(filename == NULL) { return NULL; }
+  if(sa_mmap(filename, flags, &map, &mapsize) != 0) { return NULL; }
+  h = (const csaheader_t *)map;
+  if((mapsize < sizeof(csaheader_t)) ||
+     (memcmp(h->magic, CSA_MAGIC, 8) != 0) ||
+     (h->version != CSA_VERSION) || (h->byteorder != 0x01020304) ||
+     (h->width != sizeof(saidx_t)) ||
+     ((n = h->n) < 1) || ((uint64_t)(saidx_t)n != n) || ((saidx_t)n < 0) ||
+     (n <= h->lastrow) || (ALPHABET_SIZE < h->sigma)) {
+    sa_munmap(map, mapsize);
+    return NULL;
+  }
+
+  /* The sections must be exactly where csa_build puts them, and C must
+     count n characters. */
+  memcpy(&layout, h, sizeof(layout));
+  if((csa_layout(&layout) != 0) ||
+     (layout.lowbits != h->lowbits) || (layout.lgn != h->lgn) ||
+     (layout.nsamples != h->nsamples) ||
+     (layout.low != h->low) || (layout.high != h->high) ||
+     (layout.select != h->select) || (layout.marks != h->marks) ||
+     (layout.markranks != h->markranks) || (layout.samples != h->samples) ||
+     (layout.size != h->size) || (h->size != (uint64_t)mapsize) ||
+     (h->C[ALPHABET_SIZE] != n)) {
+    sa_munmap(map, mapsize);
+    return NULL;
+  }
+  for(c = 0; (c < ALPHABET_SIZE) && (h->C[c] <= h->C[c + 1]); ++c) { }
+  if(c == ALPHABET_SIZE) { csa_checksum(map, crc); }
+
+  /* A damaged Psi' or select word would send csa_get past the end of
+     high, so every section must match its checksum. */
+  if((c < ALPHABET_SIZE) ||
+     (memcmp(crc, h->crc, sizeof(crc)) != 0) ||
+     ((csa = (csa_t *)calloc(1, sizeof(csa_t))) == NULL)) {
+    sa_munmap(map, mapsize);
+    return NULL;
+  }
+  csa->buf = map, csa->bufsize = mapsize, csa->mapped = 1;
+  csa_attach(csa);
+  return csa;
+}
+
+/* Writes a compressed suffix array to a file. */
+saint_t
+csa_write(const csa_t *csa, const char *filename) {
+  FILE *fp;
+  saint_t err;
+  if((csa == NULL) || (filename == NULL)) { return -1; }
+  if((fp = fopen(filename, "wb")) == NULL) { return -1; }
+  err = (fwrite(csa->buf, csa->bufsize, 1, fp) == 1) ? 0 : -1;
+  if(fclose(fp) != 0) { err = -1; }
+  return err;
+}
+
+/* Deallocates or unmaps a compressed suffix array. */
+void
+csa_free(csa_t *csa) {
+  if(csa == NULL) { return; }
+  if(csa->mapped != 0) { sa_munmap(csa->buf, csa->bufsize); }
+  else { free(csa->buf); }
+  free(csa);
+}
+
+/* Returns the number of bytes used by a compressed suffix array. */
+saidx_t
+csa_size(const csa_t *csa) {
+  if(csa == NULL) { return -1; }
+  return (saidx_t)(sizeof(csa_t) + csa->bufsize);
+}
+
+/* Returns SA[i]. */
+saidx_t
+csa_lookup(const csa_t *csa, saidx_t i) {
+  uint64_t x;
+  saidx_t steps;
+
+  if((csa == NULL) || (i < 0) || (csa->n <= i)) { return -1; }
+  /* A sample or the last suffix lies within sample - 1 steps. */
+  for(steps = 0; steps < csa->sample; ++steps) {
+    if(i == csa->lastrow) { return csa->n - 1 - steps; }
+    if(csa_ismarked(csa, i)) { return csa->samples[csa_markrank(csa, i)] - steps; }
+    x = csa_get(csa, i);
+    i = (saidx_t)(x & (((uint64_t)1 << csa->lgn) - 1));
+    if(csa->n <= i) { return -1; }
+  }
+  return -1;
+}
+
+/* Search for the pattern P in a compressed suffix array. */
+saidx_t
+csa_search(const csa_t *csa, const sauchar_t *P, saidx_t Psize, saidx_t *idx) {
+  saidx_t i, j, size, half, first, last;
+
+  if(idx != NULL) { *idx = -1; }
+  if((csa == NULL) || (P == NULL) || (Psize < 0)) { return -1; }
+  if(Psize == 0) { if(idx != NULL) { *idx = 0; } return csa->n; }
+
+  /* Only the bucket of P[0] can match. */
+  first = (saidx_t)csa->header->C[P[0]];
+  last = (saidx_t)csa->header->C[P[0] + 1];
+
+  /* The lower bound. */
+  for(i = first, size = last - first; 0 < size; size = half) {
+    half = size >> 1;
+    if(csa_compare(csa, i + half, P, Psize) < 0) {
+      i += half + 1;
+      half = size - half - 1;
+    }
+  }
+  /* The upper bound. */
+  for(j = i, size = last - i; 0 < size; size = half) {
+    half = size >> 1;
+    if(csa_compare(csa, j + half, P, Psize) <= 0) {
+      j += half + 1;
+      half = size - half - 1;
+    }
+  }
+
+  if(idx != NULL) { *idx = i; }
+  return j - i;
+}
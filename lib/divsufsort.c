@@ -25,28 +25,104 @@
  */
 
 #include "divsufsort_private.h"
+#include <time.h>
 #ifdef _OPENMP
 # include <omp.h>
 #endif
 
 
+/* Ends the current phase of a sort, adding its wall-clock time to a
+   field of the statistics if they are collected. */
+#define STATS_LAP(_ctx, _phase)\
+  do {\
+    if((_ctx)->stats != NULL) {\
+      double _t = wallclock();\
+      (_ctx)->stats->_phase += _t - (_ctx)->lap, (_ctx)->lap = _t;\
+    }\
+  } while(0)
+
+
 /*- Private Functions -*/
 
+/* Returns the wall-clock time in seconds. */
+static
+double
+wallclock(void) {
+#if defined(_OPENMP)
+  return omp_get_wtime();
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#else
+  return (double)clock() / (double)CLOCKS_PER_SEC;
+#endif
+}
+
+/* Starts a phase of the progress, which runs from lo to hi as total units
+   of work are reported. */
+void
+progress_phase(sactx_t *ctx, double lo, double hi, saidx_t total) {
+  ctx->lo = lo, ctx->hi = hi;
+  ctx->done = ctx->reported = 0, ctx->total = (0 < total) ? total : 1;
+}
+
+/* Reports step more units of work done in the current phase, calling the
+   callback once every SA_PROGRESS_INTERVAL units and at the end of the
+   phase. Returns nonzero once the sort has been cancelled. */
+saint_t
+progress_report(sactx_t *ctx, saidx_t step) {
+  double f;
+
+#ifdef _OPENMP
+#pragma omp critical(sa_progress)
+#endif
+  {
+    ctx->done += step;
+    if((ctx->cancelled == 0) &&
+       ((SA_PROGRESS_INTERVAL <= (ctx->done - ctx->reported)) ||
+        ((ctx->reported < ctx->total) && (ctx->total <= ctx->done)))) {
+      f = (ctx->done < ctx->total) ? (double)ctx->done / (double)ctx->total : 1.0;
+      f = ctx->lo + (ctx->hi - ctx->lo) * f;
+      if(ctx->fraction < f) { ctx->fraction = f; }
+      ctx->reported = ctx->done;
+      if(ctx->progress(ctx->fraction, ctx->arg) != 0) { ctx->cancelled = 1; }
+    }
+  }
+
+  return ctx->cancelled;
+}
+
+/* Prepares the context of a sort. */
+static
+void
+ctx_init(sactx_t *ctx, const divsufsort_tuning_t *tuning,
+         divsufsort_stats_t *stats, saidx_t n) {
+  ctx->tuning = tuning, ctx->stats = stats;
+  ctx->progress = NULL, ctx->arg = NULL;
+  ctx->fraction = 0.0, ctx->cancelled = 0;
+  progress_phase(ctx, 0.0, 1.0, n);
+  if(stats != NULL) {
+    memset(stats, 0, sizeof(divsufsort_stats_t));
+    stats->n = n, ctx->lap = wallclock();
+  }
+}
+
 /* Sorts suffixes of type B*. */
 static
 saidx_t
 sort_typeBstar(const sauchar_t *T, saidx_t *SA,
                saidx_t *bucket_A, saidx_t *bucket_B,
-               saidx_t n) {
+               saidx_t n, sactx_t *ctx) {
   saidx_t *PAb, *ISAb, *buf;
 #ifdef _OPENMP
   saidx_t *curbuf;
-  saidx_t l;
+  saidx_t l, share;
 #endif
-  saidx_t i, j, k, t, m, bufsize;
+  saidx_t i, j, k, t, m, bufsize, nbuckets;
   saint_t c0, c1;
 #ifdef _OPENMP
-  saint_t d0, d1;
+  saint_t d0, d1, nthreads;
   int tmp;
 #endif
 
@@ -57,7 +133,12 @@ sort_typeBstar(const sauchar_t *T, saidx_t *SA,
   /* Count the number of occurrences of the first one or two characters of each
      type A, B and B* suffix. Moreover, store the beginning position of all
      type B* suffixes into the array SA. */
-  for(i = n - 1, m = n, c0 = T[n - 1]; 0 <= i;) {
+  progress_phase(ctx, 0.0, 0.05, n);
+  for(i = n - 1, m = n, c0 = T[n - 1], k = n; 0 <= i;) {
+    if((ctx->progress != NULL) && (SA_PROGRESS_INTERVAL <= (k - i))) {
+      if(progress_report(ctx, k - i) != 0) { return 0; }
+      k = i;
+    }
     /* type A suffix. */
     do { ++BUCKET_A(c1 = c0); } while((0 <= --i) && ((c0 = T[i]) >= c1));
     if(0 <= i) {
@@ -88,6 +169,8 @@ note:
       i += BUCKET_B(c0, c1);
     }
   }
+  if(ctx->stats != NULL) { ctx->stats->m = m; }
+  STATS_LAP(ctx, time_count);
 
   if(0 < m) {
     /* Sort the type B* suffixes by their first two characters. */
@@ -100,19 +183,38 @@ note:
     SA[--BUCKET_BSTAR(c0, c1)] = m - 1;
 
     /* Sort the type B* substrings using sssort. */
+    progress_phase(ctx, 0.05, 0.55, m);
 #ifdef _OPENMP
     tmp = omp_get_max_threads();
+    /* A bucket holding more than a thread's share of the suffixes would
+       serialize the loop below. If sssort will sort it on all the threads,
+       it is sorted first and skipped there; otherwise it stays in the loop,
+       where the other buckets overlap with it. */
+    nthreads = (omp_in_parallel() == 0) ? tmp : 1, share = m / tmp;
+#define BUCKET_ISLARGE(_k, _l)\
+  ((share <= ((_l) - (_k))) &&\
+   (ss_isparallel(ctx, ((_l) - (_k)) - (SA[_k] == (m - 1)), n - (2 * m), nthreads) != 0))
+    for(c0 = ALPHABET_SIZE - 2, j = m; 0 < j; --c0) {
+      for(c1 = ALPHABET_SIZE - 1; c0 < c1; j = i, --c1) {
+        i = BUCKET_BSTAR(c0, c1);
+        if((1 < (j - i)) && BUCKET_ISLARGE(i, j) && (ctx->cancelled == 0)) {
+          sssort(T, PAb, SA + i, SA + j,
+                 SA + m, n - (2 * m), 2, n, *(SA + i) == (m - 1), ctx);
+          if(ctx->stats != NULL) { ++ctx->stats->ss_parallel_buckets; }
+        }
+      }
+    }
     buf = SA + m, bufsize = (n - (2 * m)) / tmp;
     c0 = ALPHABET_SIZE - 2, c1 = ALPHABET_SIZE - 1, j = m;
-#pragma omp parallel default(shared) private(curbuf, k, l, d0, d1, tmp)
+#pragma omp parallel default(shared) private(curbuf, k, l, d0, d1, tmp, nbuckets)
     {
       tmp = omp_get_thread_num();
       curbuf = buf + tmp * bufsize;
-      k = 0;
+      k = 0, nbuckets = 0;
       for(;;) {
         #pragma omp critical(sssort_lock)
         {
-          if(0 < (l = j)) {
+          if(0 < (l = (ctx->cancelled == 0) ? j : 0)) {
             d0 = c0, d1 = c1;
             do {
               k = BUCKET_BSTAR(d0, d1);
@@ -120,27 +222,38 @@ note:
                 d1 = ALPHABET_SIZE - 1;
                 if(--d0 < 0) { break; }
               }
-            } while(((l - k) <= 1) && (0 < (l = k)));
+            } while((((l - k) <= 1) || BUCKET_ISLARGE(k, l)) && (0 < (l = k)));
             c0 = d0, c1 = d1, j = k;
+            if((1 < (l - k)) && BUCKET_ISLARGE(k, l)) { l = 0; }
           }
         }
         if(l == 0) { break; }
         sssort(T, PAb, SA + k, SA + l,
-               curbuf, bufsize, 2, n, *(SA + k) == (m - 1));
+               curbuf, bufsize, 2, n, *(SA + k) == (m - 1), ctx);
+        ++nbuckets;
+      }
+      if(ctx->stats != NULL) {
+        if(tmp < DIVSUFSORT_STATS_MAXTHREADS) { ctx->stats->buckets[tmp] = nbuckets; }
+        if(tmp == 0) { ctx->stats->nthreads = omp_get_num_threads(); }
       }
     }
+#undef BUCKET_ISLARGE
 #else
     buf = SA + m, bufsize = n - (2 * m);
-    for(c0 = ALPHABET_SIZE - 2, j = m; 0 < j; --c0) {
+    for(c0 = ALPHABET_SIZE - 2, j = m, nbuckets = 0; 0 < j; --c0) {
       for(c1 = ALPHABET_SIZE - 1; c0 < c1; j = i, --c1) {
         i = BUCKET_BSTAR(c0, c1);
-        if(1 < (j - i)) {
+        if((1 < (j - i)) && (ctx->cancelled == 0)) {
           sssort(T, PAb, SA + i, SA + j,
-                 buf, bufsize, 2, n, *(SA + i) == (m - 1));
+                 buf, bufsize, 2, n, *(SA + i) == (m - 1), ctx);
+          ++nbuckets;
         }
       }
     }
+    if(ctx->stats != NULL) { ctx->stats->buckets[0] = nbuckets, ctx->stats->nthreads = 1; }
 #endif
+    STATS_LAP(ctx, time_sssort);
+    if(ctx->cancelled != 0) { return m; }
 
     /* Compute ranks of type B* substrings. */
     for(i = m - 1; 0 <= i; --i) {
@@ -155,8 +268,13 @@ note:
       ISAb[SA[i]] = j;
     }
 
+    STATS_LAP(ctx, time_rank);
+
     /* Construct the inverse suffix array of type B* suffixes using trsort. */
-    trsort(ISAb, SA, m, 1);
+    progress_phase(ctx, 0.55, 0.75, m);
+    trsort(ISAb, SA, m, 1, ctx);
+    STATS_LAP(ctx, time_trsort);
+    if(ctx->cancelled != 0) { return m; }
 
     /* Set the sorted order of tyoe B* suffixes. */
     for(i = n - 1, j = m, c0 = T[n - 1]; 0 <= i;) {
@@ -191,18 +309,31 @@ note:
 
 /* Constructs the suffix array by using the sorted order of type B* suffixes. */
 static
-void
+saint_t
 construct_SA(const sauchar_t *T, saidx_t *SA,
              saidx_t *bucket_A, saidx_t *bucket_B,
-             saidx_t n, saidx_t m) {
-  saidx_t *i, *j, *k;
-  saidx_t s;
+             saidx_t n, saidx_t m,
+             saint_t (*sink)(const saidx_t *, saidx_t, void *), void *arg,
+             sactx_t *ctx) {
+  saidx_t *i, *j, *k, *l, *e;
+  saidx_t s, w;
   saint_t c0, c1, c2;
 
   if(0 < m) {
     /* Construct the sorted order of type B suffixes by using
        the sorted order of type B* suffixes. */
-    for(c1 = ALPHABET_SIZE - 2; 0 <= c1; --c1) {
+    for(c1 = 0, w = 0; c1 < (ALPHABET_SIZE - 1); ++c1) {
+      w += BUCKET_A(c1 + 1) - BUCKET_BSTAR(c1, c1 + 1);
+    }
+    progress_phase(ctx, 0.75, 0.85, w);
+    for(c1 = ALPHABET_SIZE - 2, w = 0; 0 <= c1; --c1) {
+      if(ctx->progress != NULL) {
+        w += BUCKET_A(c1 + 1) - BUCKET_BSTAR(c1, c1 + 1);
+        if((SA_PROGRESS_INTERVAL <= w) || (c1 == 0)) {
+          if(progress_report(ctx, w) != 0) { return -4; }
+          w = 0;
+        }
+      }
       /* Scan the suffix array from right to left. */
       for(i = SA + BUCKET_BSTAR(c1, c1 + 1),
           j = SA + BUCKET_A(c1 + 1) - 1, k = NULL, c2 = -1;
@@ -233,23 +364,34 @@ construct_SA(const sauchar_t *T, saidx_t *SA,
      the sorted order of type B suffixes. */
   k = SA + BUCKET_A(c2 = T[n - 1]);
   *k++ = (T[n - 2] < c2) ? ~(n - 1) : (n - 1);
-  /* Scan the suffix array from left to right. */
-  for(i = SA, j = SA + n; i < j; ++i) {
-    if(0 < (s = *i)) {
-      assert(T[s - 1] >= T[s]);
-      c0 = T[--s];
-      if((s == 0) || (T[s - 1] < c0)) { s = ~s; }
-      if(c0 != c2) {
-        BUCKET_A(c2) = k - SA;
-        k = SA + BUCKET_A(c2 = c0);
+  /* Scan the suffix array from left to right. Only positions after i are
+     written, so SA[0..i] is final once the scan has passed i and is handed
+     to the sink chunk by chunk. */
+  progress_phase(ctx, 0.85, 1.0, n);
+  for(i = l = SA, j = SA + n; i < j; l = i) {
+    e = (((sink != NULL) || (ctx->progress != NULL)) &&
+         (SA_SINK_CHUNKSIZE < (j - i))) ? i + SA_SINK_CHUNKSIZE : j;
+    for(; i < e; ++i) {
+      if(0 < (s = *i)) {
+        assert(T[s - 1] >= T[s]);
+        c0 = T[--s];
+        if((s == 0) || (T[s - 1] < c0)) { s = ~s; }
+        if(c0 != c2) {
+          BUCKET_A(c2) = k - SA;
+          k = SA + BUCKET_A(c2 = c0);
+        }
+        assert(i < k);
+        *k++ = s;
+      } else {
+        assert(s < 0);
+        *i = ~s;
       }
-      assert(i < k);
-      *k++ = s;
-    } else {
-      assert(s < 0);
-      *i = ~s;
     }
+    if((sink != NULL) && (sink(l, (saidx_t)(i - l), arg) != 0)) { return -3; }
+    if((ctx->progress != NULL) && (progress_report(ctx, (saidx_t)(i - l)) != 0)) { return -4; }
   }
+
+  return 0;
 }
 
 /* Constructs the burrows-wheeler transformed string directly
@@ -323,30 +465,55 @@ construct_BWT(const sauchar_t *T, saidx_t *SA,
   return orig - SA;
 }
 
+/* Fills in the BWT rows of a finished chunk of the suffix array. */
+typedef struct {
+  const sauchar_t *T;
+  sauchar_t *U;
+  const saidx_t *SA;
+  saidx_t orig;
+} bwt_sink_t;
 
-/*---------------------------------------------------------------------------*/
-
-/*- Function -*/
+static
+saint_t
+bwt_chunk(const saidx_t *SA, saidx_t size, void *arg) {
+  bwt_sink_t *b = (bwt_sink_t *)arg;
+  const sauchar_t *T = b->T;
+  sauchar_t *U = b->U;
+  saidx_t i, j, s;
+
+  /* Row i goes to U[i + 1] before the primary index and to U[i] after it. */
+  for(i = SA - b->SA, j = i + size; i < j; ++i) {
+    if(0 < (s = b->SA[i])) { U[i + (b->orig < 0)] = T[s - 1]; }
+    else { b->orig = i; }
+  }
+  return 0;
+}
 
+/* Constructs the suffix array, handing its chunks to sink. */
+static
 saint_t
-divsufsort(const sauchar_t *T, saidx_t *SA, saidx_t n) {
+suffixsort(const sauchar_t *T, saidx_t *SA, saidx_t n,
+           saint_t (*sink)(const saidx_t *SA, saidx_t size, void *arg),
+           void *arg, sactx_t *ctx) {
   saidx_t *bucket_A, *bucket_B;
   saidx_t m;
   saint_t err = 0;
 
-  /* Check arguments. */
-  if((T == NULL) || (SA == NULL) || (n < 0)) { return -1; }
-  else if(n == 0) { return 0; }
-  else if(n == 1) { SA[0] = 0; return 0; }
-  else if(n == 2) { m = (T[0] < T[1]); SA[m ^ 1] = 0, SA[m] = 1; return 0; }
+  if(n <= 2) {
+    if(n == 1) { SA[0] = 0; }
+    else if(n == 2) { m = (T[0] < T[1]); SA[m ^ 1] = 0, SA[m] = 1; }
+    return ((0 < n) && (sink != NULL) && (sink(SA, n, arg) != 0)) ? -3 : 0;
+  }
 
   bucket_A = (saidx_t *)malloc(BUCKET_A_SIZE * sizeof(saidx_t));
   bucket_B = (saidx_t *)malloc(BUCKET_B_SIZE * sizeof(saidx_t));
 
   /* Suffixsort. */
   if((bucket_A != NULL) && (bucket_B != NULL)) {
-    m = sort_typeBstar(T, SA, bucket_A, bucket_B, n);
-    construct_SA(T, SA, bucket_A, bucket_B, n, m);
+    m = sort_typeBstar(T, SA, bucket_A, bucket_B, n, ctx);
+    err = (ctx->cancelled == 0) ?
+          construct_SA(T, SA, bucket_A, bucket_B, n, m, sink, arg, ctx) : -4;
+    STATS_LAP(ctx, time_induce);
   } else {
     err = -2;
   }
@@ -357,15 +524,113 @@ divsufsort(const sauchar_t *T, saidx_t *SA, saidx_t n) {
   return err;
 }
 
+
+/*---------------------------------------------------------------------------*/
+
+/*- Function -*/
+
+saint_t
+divsufsort(const sauchar_t *T, saidx_t *SA, saidx_t n) {
+  return divsufsort_sink(T, SA, n, NULL, NULL);
+}
+
+saint_t
+divsufsort_sink(const sauchar_t *T, saidx_t *SA, saidx_t n,
+                saint_t (*sink)(const saidx_t *SA, saidx_t size, void *arg),
+                void *arg) {
+  divsufsort_tuning_t tuning;
+  sactx_t ctx;
+
+  /* Check arguments. */
+  if((T == NULL) || (SA == NULL) || (n < 0)) { return -1; }
+
+  divsufsort_tuning_default(&tuning);
+  ctx_init(&ctx, &tuning, NULL, n);
+  return suffixsort(T, SA, n, sink, arg, &ctx);
+}
+
+saint_t
+divsufsort_tuned(const sauchar_t *T, saidx_t *SA, saidx_t n,
+                 const divsufsort_tuning_t *tuning) {
+  divsufsort_tuning_t t;
+  sactx_t ctx;
+
+  /* Check arguments. */
+  if((T == NULL) || (SA == NULL) || (n < 0) ||
+     ((tuning != NULL) && (tuning_check(tuning) != 0))) { return -1; }
+
+  if(tuning == NULL) { divsufsort_tuning_default(&t); tuning = &t; }
+  ctx_init(&ctx, tuning, NULL, n);
+  return suffixsort(T, SA, n, NULL, NULL, &ctx);
+}
+
+saint_t
+divsufsort_stats(const sauchar_t *T, saidx_t *SA, saidx_t n,
+                 divsufsort_stats_t *stats) {
+  divsufsort_tuning_t tuning;
+  sactx_t ctx;
+
+  /* Check arguments. */
+  if((T == NULL) || (SA == NULL) || (n < 0)) { return -1; }
+
+  divsufsort_tuning_default(&tuning);
+  ctx_init(&ctx, &tuning, stats, n);
+  return suffixsort(T, SA, n, NULL, NULL, &ctx);
+}
+
+saint_t
+divsufsort_progress(const sauchar_t *T, saidx_t *SA, saidx_t n,
+                    saint_t (*progress)(double fraction, void *arg),
+                    void *arg) {
+  divsufsort_tuning_t tuning;
+  sactx_t ctx;
+
+  /* Check arguments. */
+  if((T == NULL) || (SA == NULL) || (n < 0)) { return -1; }
+
+  divsufsort_tuning_default(&tuning);
+  ctx_init(&ctx, &tuning, NULL, n);
+  ctx.progress = progress, ctx.arg = arg;
+  return suffixsort(T, SA, n, NULL, NULL, &ctx);
+}
+
+saidx_t
+divsufsort_bwt(const sauchar_t *T, saidx_t *SA, sauchar_t *U, saidx_t n) {
+  bwt_sink_t b;
+  saint_t err;
+
+  /* Check arguments. */
+  if((T == NULL) || (SA == NULL) || (U == NULL) || (T == U) || (n < 0)) { return -1; }
+  else if(n == 0) { return 0; }
+
+  /* Suffixsort, filling in U behind the final scan. */
+  b.T = T, b.U = U, b.SA = SA, b.orig = -1;
+  if((err = divsufsort_sink(T, SA, n, bwt_chunk, &b)) != 0) { return err; }
+  U[0] = T[n - 1];
+
+  return b.orig + 1;
+}
+
 saidx_t
 divbwt(const sauchar_t *T, sauchar_t *U, saidx_t *A, saidx_t n) {
+  return divbwt_stats(T, U, A, n, NULL);
+}
+
+saidx_t
+divbwt_stats(const sauchar_t *T, sauchar_t *U, saidx_t *A, saidx_t n,
+             divsufsort_stats_t *stats) {
   saidx_t *B;
   saidx_t *bucket_A, *bucket_B;
   saidx_t m, pidx, i;
+  divsufsort_tuning_t tuning;
+  sactx_t ctx;
 
   /* Check arguments. */
   if((T == NULL) || (U == NULL) || (n < 0)) { return -1; }
-  else if(n <= 1) { if(n == 1) { U[0] = T[0]; } return n; }
+
+  divsufsort_tuning_default(&tuning);
+  ctx_init(&ctx, &tuning, stats, n);
+  if(n <= 1) { if(n == 1) { U[0] = T[0]; } return n; }
 
   if((B = A) == NULL) { B = (saidx_t *)malloc((size_t)(n + 1) * sizeof(saidx_t)); }
   bucket_A = (saidx_t *)malloc(BUCKET_A_SIZE * sizeof(saidx_t));
@@ -373,8 +638,9 @@ divbwt(const sauchar_t *T, sauchar_t *U, saidx_t *A, saidx_t n) {
 
   /* Burrows-Wheeler Transform. */
   if((B != NULL) && (bucket_A != NULL) && (bucket_B != NULL)) {
-    m = sort_typeBstar(T, B, bucket_A, bucket_B, n);
+    m = sort_typeBstar(T, B, bucket_A, bucket_B, n, &ctx);
     pidx = construct_BWT(T, B, bucket_A, bucket_B, n, m);
+    STATS_LAP(&ctx, time_induce);
 
     /* Copy to output string. */
     U[0] = T[n - 1];
@@ -0,0 +1,333 @@
+/*
+ * fmindex.c for libdivsufsort
+ * Copyright (c) 2003-2008 Yuta Mori All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "divsufsort_private.h"
+
+
+/*- Datatypes -*/
+
+struct _fmindex_t {
+  saidx_t n;             /* the length of the text */
+  saidx_t pidx;          /* the primary index */
+  saidx_t C[ALPHABET_SIZE + 1];
+  saint_t map[ALPHABET_SIZE]; /* symbol -> header slot, or -1 if absent */
+  saint_t sigma;         /* the number of distinct symbols */
+  saint_t lgblock;
+  saidx_t blocksize, headerbytes, blockbytes, nblocks;
+  sauchar_t *blocks;     /* [header | BWT bytes] per block, 64-byte aligned */
+  sauchar_t *rawblocks;
+  saidx_t *super;        /* absolute counts per superblock */
+  uint64_t *marks;       /* rows holding an SA sample */
+  saidx_t *markranks;    /* the number of marks before each 512 rows */
+  saidx_t *sa, *isa;
+  saidx_t sasample, isasample, nsa, nisa;
+};
+
+
+/*- Private Functions -*/
+
+static INLINE
+saint_t
+fm_popcount(uint64_t x) {
+#if defined(__GNUC__) && defined(__POPCNT__)
+  return __builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return (saint_t)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* Returns the number of symbols c in U[0..n-1], eight bytes at a time. */
+static INLINE
+saidx_t
+fm_countbytes(const sauchar_t *U, saidx_t n, saint_t c) {
+  uint64_t x, y, ones = 0x0101010101010101ULL, highs = 0x8080808080808080ULL;
+  saidx_t i, k;
+  for(i = 0, k = 0, y = ones * (uint64_t)c; (i + 8) <= n; i += 8) {
+    memcpy(&x, U + i, 8);
+    x ^= y;
+    /* The high bit of each byte of x is set iff that byte is nonzero. */
+    x = (((x & ~highs) + ~highs) | x) & highs;
+    k += 8 - (saidx_t)(((x >> 7) * ones) >> 56);
+  }
+  for(; i < n; ++i) { k += (U[i] == c); }
+  return k;
+}
+
+/* Returns the header (16-bit counts) and the BWT bytes of block b. */
+#define FM_BLOCK(_fm, _b) ((_fm)->blocks + (size_t)(_b) * (_fm)->blockbytes)
+#define FM_HEADER(_fm, _b) ((const uint16_t *)FM_BLOCK(_fm, _b))
+#define FM_DATA(_fm, _b) (FM_BLOCK(_fm, _b) + (_fm)->headerbytes)
+#define FM_SUPER(_fm, _b, _s) \
+  ((_fm)->super[((_b) >> (FM_SUPERBLOCK_LG - (_fm)->lgblock)) * (_fm)->sigma + (_s)])
+
+/* Returns the number of symbols c in U[0..i-1]. */
+static INLINE
+saidx_t
+fm_rank(const fmindex_t *fm, saint_t c, saidx_t i) {
+  saidx_t b, off;
+  saint_t s;
+
+  if((s = fm->map[c]) < 0) { return 0; }
+  b = i >> fm->lgblock, off = i & (fm->blocksize - 1);
+  if((off <= (fm->blocksize >> 1)) || (fm->n < ((b + 1) << fm->lgblock))) {
+    return FM_SUPER(fm, b, s) + FM_HEADER(fm, b)[s] +
+           fm_countbytes(FM_DATA(fm, b), off, c);
+  }
+  /* Count backward from the start of the next block. */
+  return FM_SUPER(fm, b + 1, s) + FM_HEADER(fm, b + 1)[s] -
+         fm_countbytes(FM_DATA(fm, b) + off, fm->blocksize - off, c);
+}
+
+/* Returns the number of symbols c in the sentinel BWT L[0..r-1]. */
+static INLINE
+saidx_t
+fm_occ(const fmindex_t *fm, saint_t c, saidx_t r) {
+  return fm_rank(fm, c, r - (fm->pidx < r));
+}
+
+/* LF-mapping. Also returns L[r] in *c (r must not be the primary index). */
+static INLINE
+saidx_t
+fm_lf(const fmindex_t *fm, saidx_t r, saint_t *c) {
+  saidx_t j = r - (fm->pidx < r);
+  *c = FM_DATA(fm, j >> fm->lgblock)[j & (fm->blocksize - 1)];
+  return fm->C[*c] + fm_rank(fm, *c, j);
+}
+
+static INLINE
+saint_t
+fm_ismarked(const fmindex_t *fm, saidx_t r) {
+  return (saint_t)((fm->marks[r >> 6] >> (r & 63)) & 1);
+}
+
+/* Returns the number of marked rows in [0..r-1]. */
+static INLINE
+saidx_t
+fm_markrank(const fmindex_t *fm, saidx_t r) {
+  saidx_t w, k;
+  for(w = (r >> 9) << 3, k = fm->markranks[r >> 9]; w < (r >> 6); ++w) {
+    k += fm_popcount(fm->marks[w]);
+  }
+  if((r & 63) != 0) { k += fm_popcount(fm->marks[w] << (64 - (r & 63))); }
+  return k;
+}
+
+
+/*---------------------------------------------------------------------------*/
+
+/*- Functions -*/
+
+/* Builds the FM-index of a BWTed string. */
+fmindex_t *
+fmindex_build(const sauchar_t *U, saidx_t n, saidx_t pidx,
+              const saidx_t *SA, saidx_t sasample, saidx_t isasample) {
+  saidx_t count[ALPHABET_SIZE];
+  fmindex_t *fm;
+  saidx_t *tmp;
+  saidx_t i, j, b, r, p, size;
+  saint_t c, s;
+
+  /* Check arguments. */
+  if((U == NULL) || (n < 1) || (pidx < 1) || (n < pidx) ||
+     (sasample < 1) || (isasample < 1)) { return NULL; }
+  if((fm = (fmindex_t *)calloc(1, sizeof(fmindex_t))) == NULL) { return NULL; }
+  fm->n = n, fm->pidx = pidx;
+  fm->sasample = sasample, fm->isasample = isasample;
+
+  /* Count the symbols and map the ones that occur to header slots. */
+  for(c = 0; c < ALPHABET_SIZE; ++c) { count[c] = 0; }
+  for(i = 0; i < n; ++i) { ++count[U[i]]; }
+  for(c = 0, s = 0, i = 1; c < ALPHABET_SIZE; ++c) {
+    fm->C[c] = i;
+    i += count[c];
+    fm->map[c] = (0 < count[c]) ? s++ : -1;
+  }
+  fm->C[ALPHABET_SIZE] = i;
+  fm->sigma = s;
+
+  /* Size the blocks so that a header is a quarter of the BWT bytes. */
+  fm->headerbytes = ((2 * s + 63) / 64) * 64;
+  for(fm->lgblock = 8; (1 << fm->lgblock) < (4 * fm->headerbytes); ++fm->lgblock) { }
+  fm->blocksize = (saidx_t)1 << fm->lgblock;
+  fm->blockbytes = fm->headerbytes + fm->blocksize;
+  fm->nblocks = (n >> fm->lgblock) + 2;
+  size = ((fm->nblocks - 1) >> (FM_SUPERBLOCK_LG - fm->lgblock)) + 1;
+
+  fm->rawblocks = (sauchar_t *)malloc((size_t)fm->nblocks * fm->blockbytes + 63);
+  fm->super = (saidx_t *)malloc((size_t)size * s * sizeof(saidx_t));
+  fm->marks = (uint64_t *)calloc((size_t)((n + 1) >> 9) + 1, 8 * sizeof(uint64_t));
+  fm->markranks = (saidx_t *)malloc((size_t)(((n + 1) >> 9) + 1) * sizeof(saidx_t));
+  fm->nsa = (n - 1) / sasample + 1;
+  fm->sa = (saidx_t *)malloc((size_t)fm->nsa * sizeof(saidx_t));
+  fm->nisa = (n - 1) / isasample + 1;
+  fm->isa = (saidx_t *)malloc((size_t)fm->nisa * sizeof(saidx_t));
+  tmp = (SA == NULL) ? (saidx_t *)malloc((size_t)fm->nsa * 2 * sizeof(saidx_t)) : NULL;
+  if((fm->rawblocks == NULL) || (fm->super == NULL) || (fm->marks == NULL) ||
+     (fm->markranks == NULL) || (fm->sa == NULL) || (fm->isa == NULL) ||
+     ((SA == NULL) && (tmp == NULL))) {
+    free(tmp);
+    fmindex_free(fm);
+    return NULL;
+  }
+  fm->blocks = fm->rawblocks + ((64 - ((size_t)fm->rawblocks & 63)) & 63);
+
+  /* Interleave the rank headers with the BWT bytes. */
+  for(c = 0; c < ALPHABET_SIZE; ++c) { count[c] = 0; }
+  for(b = 0; b < fm->nblocks; ++b) {
+    uint16_t *header = (uint16_t *)FM_BLOCK(fm, b);
+    sauchar_t *data = FM_DATA(fm, b);
+    if((b & ((1 << (FM_SUPERBLOCK_LG - fm->lgblock)) - 1)) == 0) {
+      for(c = 0; c < ALPHABET_SIZE; ++c) {
+        if(0 <= fm->map[c]) { FM_SUPER(fm, b, fm->map[c]) = count[c]; }
+      }
+    }
+    for(c = 0; c < ALPHABET_SIZE; ++c) {
+      if(0 <= fm->map[c]) {
+        header[fm->map[c]] = (uint16_t)(count[c] - FM_SUPER(fm, b, fm->map[c]));
+      }
+    }
+    for(i = b << fm->lgblock, j = 0; j < fm->blocksize; ++i, ++j) {
+      if(i < n) { ++count[data[j] = U[i]]; }
+      else { data[j] = 0; }
+    }
+  }
+
+  /* Sample SA by text position, and ISA. */
+  if(SA != NULL) {
+    for(r = 1; r <= n; ++r) {
+      p = SA[r - 1];
+      if((p % sasample) == 0) { fm->marks[r >> 6] |= (uint64_t)1 << (r & 63); }
+      if((p % isasample) == 0) { fm->isa[p / isasample] = r; }
+    }
+  } else {
+    /* Walk the text backward from the sentinel row. */
+    for(r = 0, p = n - 1, j = 0; 0 <= p; --p) {
+      r = fm_lf(fm, r, &c);
+      if((p % sasample) == 0) {
+        fm->marks[r >> 6] |= (uint64_t)1 << (r & 63);
+        tmp[j++] = r, tmp[j++] = p;
+      }
+      if((p % isasample) == 0) { fm->isa[p / isasample] = r; }
+    }
+  }
+  for(i = 0, j = 0; i <= (n >> 9); ++i) {
+    fm->markranks[i] = j;
+    for(b = 0; b < 8; ++b) { j += fm_popcount(fm->marks[i * 8 + b]); }
+  }
+  if(SA != NULL) {
+    for(r = 1; r <= n; ++r) {
+      if(fm_ismarked(fm, r)) { fm->sa[fm_markrank(fm, r)] = SA[r - 1]; }
+    }
+  } else {
+    for(i = 0; i < (2 * fm->nsa); i += 2) { fm->sa[fm_markrank(fm, tmp[i])] = tmp[i + 1]; }
+    free(tmp);
+  }
+
+  return fm;
+}
+
+/* Deallocates an FM-index. */
+void
+fmindex_free(fmindex_t *fm) {
+  if(fm == NULL) { return; }
+  free(fm->isa);
+  free(fm->sa);
+  free(fm->markranks);
+  free(fm->marks);
+  free(fm->super);
+  free(fm->rawblocks);
+  free(fm);
+}
+
+/* Returns the number of bytes used by an FM-index. */
+saidx_t
+fmindex_size(const fmindex_t *fm) {
+  if(fm == NULL) { return -1; }
+  return (saidx_t)(sizeof(fmindex_t) +
+    (size_t)fm->nblocks * fm->blockbytes +
+    (size_t)(((fm->nblocks - 1) >> (FM_SUPERBLOCK_LG - fm->lgblock)) + 1) *
+      fm->sigma * sizeof(saidx_t) +
+    (size_t)(((fm->n + 1) >> 9) + 1) * (8 * sizeof(uint64_t) + sizeof(saidx_t)) +
+    (size_t)(fm->nsa + fm->nisa) * sizeof(saidx_t));
+}
+
+/* Counts the occurrences of the pattern P by backward search. */
+saidx_t
+fmindex_count(const fmindex_t *fm,
+              const sauchar_t *P, saidx_t Psize, saidx_t *idx) {
+  saidx_t sp, ep;
+  saint_t c;
+
+  if(idx != NULL) { *idx = -1; }
+  if((fm == NULL) || (P == NULL) || (Psize < 0)) { return -1; }
+  if(Psize == 0) { if(idx != NULL) { *idx = 0; } return fm->n; }
+
+  for(sp = 0, ep = fm->n + 1; (0 < Psize) && (sp < ep);) {
+    c = P[--Psize];
+    sp = fm->C[c] + fm_occ(fm, c, sp);
+    ep = fm->C[c] + fm_occ(fm, c, ep);
+  }
+
+  if(ep <= sp) { return 0; }
+  if(idx != NULL) { *idx = sp - 1; }
+  return ep - sp;
+}
+
+/* Returns SA[i]. */
+saidx_t
+fmindex_locate(const fmindex_t *fm, saidx_t i) {
+  saidx_t r, steps;
+  saint_t c;
+
+  if((fm == NULL) || (i < 0) || (fm->n <= i)) { return -1; }
+  for(r = i + 1, steps = 0; fm_ismarked(fm, r) == 0; ++steps) { r = fm_lf(fm, r, &c); }
+  return fm->sa[fm_markrank(fm, r)] + steps;
+}
+
+/* Extracts T[i..i+size-1]. */
+saint_t
+fmindex_extract(const fmindex_t *fm, saidx_t i, saidx_t size, sauchar_t *U) {
+  saidx_t p, r;
+  saint_t c;
+
+  if((fm == NULL) || (U == NULL) || (i < 0) || (size < 0) ||
+     (fm->n - i < size)) { return -1; }
+  if(size == 0) { return 0; }
+
+  /* Start from the nearest ISA sample at or after the end. */
+  p = ((i + size - 1) / fm->isasample + 1) * fm->isasample;
+  if(fm->n <= p) { p = fm->n, r = 0; }
+  else { r = fm->isa[p / fm->isasample]; }
+  for(; i < p; --p) {
+    r = fm_lf(fm, r, &c);
+    if(p <= (i + size)) { U[p - 1 - i] = (sauchar_t)c; }
+  }
+
+  return 0;
+}
@@ -0,0 +1,255 @@
+/*
+ * indexfile.c for libdivsufsort
+ * Copyright (c) 2003-2008 Yuta Mori All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "divsufsort_private.h"
+
+
+/*- Private Functions -*/
+
+/* The header of an index file. All fields are in native byte order;
+   byteorder tells a reader whether that matches its own. */
+typedef struct _saindexsection_t saindexsection_t;
+struct _saindexsection_t {
+  uint32_t type;
+  uint32_t param;        /* the depth of a bucket index or the step of a prefix cache */
+  uint64_t offset;       /* from the start of the file, SA_INDEX_ALIGN-aligned */
+  uint64_t size;         /* in bytes */
+};
+typedef struct _saindexheader_t saindexheader_t;
+struct _saindexheader_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteorder;
+  uint32_t width;        /* sizeof(saidx_t) */
+  uint32_t nsections;
+  uint64_t n;
+  uint32_t textcrc;      /* CRC-32C of the text */
+  uint32_t reserved;
+  saindexsection_t sections[SA_INDEX_MAXSECTIONS];
+};
+
+static
+saint_t
+_write_padding(FILE *fp, uint64_t *pos, uint64_t offset) {
+  static const char zeros[256] = { 0 };
+  size_t size;
+  for(; *pos < offset; *pos += size) {
+    size = (size_t)MIN(offset - *pos, (uint64_t)sizeof(zeros));
+    if(fwrite(zeros, 1, size, fp) != size) { return -1; }
+  }
+  return 0;
+}
+
+/* Returns the expected size of a section, or 0 for an unknown type. */
+static
+uint64_t
+_section_size(uint32_t type, uint32_t param, saidx_t n) {
+  switch(type) {
+  case SA_INDEX_SECTION_TEXT: return (uint64_t)n * sizeof(sauchar_t);
+  case SA_INDEX_SECTION_SA:
+  case SA_INDEX_SECTION_LCP: return (uint64_t)n * sizeof(saidx_t);
+  case SA_INDEX_SECTION_BUCKETINDEX:
+    return ((param == 1) || (param == 2)) ?
+      (uint64_t)SA_BUCKETINDEX_SIZE(param) * sizeof(saidx_t) : 0;
+  case SA_INDEX_SECTION_PREFIXCACHE:
+    return (0 < param) ? (uint64_t)SA_PREFIXCACHE_SIZE(n, (saidx_t)param) : 0;
+  default: break;
+  }
+  return 0;
+}
+
+
+/*- Functions -*/
+
+/* Writes an index file. */
+saint_t
+sa_index_write(const char *filename,
+               const sauchar_t *T, const saidx_t *SA, saidx_t n,
+               const saidx_t *LCP, saint_t depth, saidx_t step,
+               saint_t flags) {
+  saindexheader_t header;
+  const void *data[SA_INDEX_MAXSECTIONS];
+  saidx_t *B;
+  sauchar_t *PC;
+  FILE *fp;
+  uint64_t pos;
+  uint32_t k;
+  saint_t err;
+
+  if((filename == NULL) || (T == NULL) || (SA == NULL) || (n < 0) ||
+     (depth < 0) || (2 < depth) || (step < 0) ||
+     ((uint64_t)(uint32_t)step != (uint64_t)step)) { return -1; }
+
+  /* Build the optional tables. */
+  B = NULL, PC = NULL;
+  if(0 < depth) {
+    if((B = (saidx_t *)malloc(SA_BUCKETINDEX_SIZE(depth) * sizeof(saidx_t))) == NULL) { return -2; }
+    sa_bucketindex(T, n, B, depth);
+  }
+  if((0 < step) && (0 < n)) {
+    if((PC = (sauchar_t *)malloc((size_t)SA_PREFIXCACHE_SIZE(n, step))) == NULL) {
+      free(B);
+      return -2;
+    }
+    sa_prefixcache(T, n, SA, n, step, PC);
+  }
+
+  /* Lay out the sections. */
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, SA_INDEX_MAGIC, 8);
+  header.version = SA_INDEX_VERSION;
+  header.byteorder = 0x01020304;
+  header.width = (uint32_t)sizeof(saidx_t);
+  header.n = (uint64_t)n;
+  header.textcrc = crc32c(0, T, (size_t)n);
+#define SA_INDEX_ADD(_type, _param, _data)\
+  do {\
+    header.sections[header.nsections].type = (_type);\
+    header.sections[header.nsections].param = (uint32_t)(_param);\
+    header.sections[header.nsections].size = _section_size((_type), (uint32_t)(_param), n);\
+    data[header.nsections++] = (_data);\
+  } while(0)
+  if(flags & SA_INDEX_TEXT) { SA_INDEX_ADD(SA_INDEX_SECTION_TEXT, 0, T); }
+  SA_INDEX_ADD(SA_INDEX_SECTION_SA, 0, SA);
+  if(LCP != NULL) { SA_INDEX_ADD(SA_INDEX_SECTION_LCP, 0, LCP); }
+  if(B != NULL) { SA_INDEX_ADD(SA_INDEX_SECTION_BUCKETINDEX, depth, B); }
+  if(0 < step) { SA_INDEX_ADD(SA_INDEX_SECTION_PREFIXCACHE, step, PC); }
+#undef SA_INDEX_ADD
+  for(k = 0, pos = SA_INDEX_ALIGN; k < header.nsections; ++k) {
+    header.sections[k].offset = pos;
+    pos += (header.sections[k].size + SA_INDEX_ALIGN - 1) & ~(uint64_t)(SA_INDEX_ALIGN - 1);
+  }
+
+  /* Write the header and the sections, each padded to a page. */
+  err = -1;
+  if((fp = fopen(filename, "wb")) != NULL) {
+    pos = sizeof(header);
+    if(fwrite(&header, sizeof(header), 1, fp) == 1) {
+      for(k = 0; k < header.nsections; ++k) {
+        if(_write_padding(fp, &pos, header.sections[k].offset) != 0) { break; }
+        if((header.sections[k].size != 0) &&
+           (fwrite(data[k], (size_t)header.sections[k].size, 1, fp) != 1)) { break; }
+        pos += header.sections[k].size;
+      }
+      if((k == header.nsections) &&
+         (_write_padding(fp, &pos, (pos + SA_INDEX_ALIGN - 1) & ~(uint64_t)(SA_INDEX_ALIGN - 1)) == 0)) {
+        err = 0;
+      }
+    }
+    if(fclose(fp) != 0) { err = -1; }
+  }
+
+  free(PC);
+  free(B);
+  return err;
+}
+
+/* Loads an index file. */
+saint_t
+sa_index_load(const char *filename, saint_t flags, saindex_t *index) {
+  const saindexheader_t *header;
+  const saindexsection_t *s;
+  const sauchar_t *p;
+  void *map;
+  size_t mapsize;
+  uint32_t k;
+  saint_t err;
+
+  if((filename == NULL) || (index == NULL)) { return -1; }
+  memset(index, 0, sizeof(saindex_t));
+  if((err = sa_mmap(filename, flags & (SA_MMAP_POPULATE | SA_MMAP_RANDOM | SA_MMAP_SEQUENTIAL),
+                    &map, &mapsize)) != 0) { return err; }
+
+  /* Check the header. */
+  header = (const saindexheader_t *)map;
+  p = (const sauchar_t *)map;
+  if((mapsize < sizeof(saindexheader_t)) ||
+     (memcmp(header->magic, SA_INDEX_MAGIC, 8) != 0) ||
+     (header->version != SA_INDEX_VERSION) || (header->byteorder != 0x01020304) ||
+     (header->width != sizeof(saidx_t)) ||
+     (SA_INDEX_MAXSECTIONS < header->nsections) ||
+     ((uint64_t)(saidx_t)header->n != header->n) || ((saidx_t)header->n < 0)) {
+    sa_munmap(map, mapsize);
+    return -3;
+  }
+  index->map = map, index->mapsize = mapsize;
+  index->n = (saidx_t)header->n;
+
+  /* Point into the sections. */
+  for(k = 0; k < header->nsections; ++k) {
+    s = &header->sections[k];
+    if(((s->offset & (SA_INDEX_ALIGN - 1)) != 0) ||
+       (mapsize < s->offset) || ((mapsize - s->offset) < s->size) ||
+       (s->size != _section_size(s->type, s->param, index->n))) {
+      if(s->type <= SA_INDEX_SECTION_PREFIXCACHE) { break; }
+      continue; /* skip the sections of a later revision */
+    }
+    switch(s->type) {
+    case SA_INDEX_SECTION_TEXT: index->T = p + s->offset; break;
+    case SA_INDEX_SECTION_SA: index->SA = (const saidx_t *)(p + s->offset); break;
+    case SA_INDEX_SECTION_LCP: index->LCP = (const saidx_t *)(p + s->offset); break;
+    case SA_INDEX_SECTION_BUCKETINDEX:
+      index->B = (const saidx_t *)(p + s->offset), index->depth = (saint_t)s->param;
+      break;
+    case SA_INDEX_SECTION_PREFIXCACHE:
+      index->PC = p + s->offset, index->step = (saidx_t)s->param;
+      break;
+    default: break;
+    }
+  }
+  if((k != header->nsections) || ((index->SA == NULL) && (0 < index->n))) {
+    sa_index_close(index);
+    return -3;
+  }
+
+  if((flags & SA_INDEX_VERIFY) && (index->T != NULL) &&
+     (sa_index_verify(index, index->T, index->n) != 0)) {
+    sa_index_close(index);
+    return -3;
+  }
+
+  return 0;
+}
+
+/* Checks that an index file was built from the string T. */
+saint_t
+sa_index_verify(const saindex_t *index, const sauchar_t *T, saidx_t n) {
+  const saindexheader_t *header;
+  if((index == NULL) || (index->map == NULL) || ((T == NULL) && (0 < n))) { return -1; }
+  header = (const saindexheader_t *)index->map;
+  if(((saidx_t)header->n != n) ||
+     (crc32c(0, T, (size_t)n) != header->textcrc)) { return -3; }
+  return 0;
+}
+
+/* Unmaps an index file. */
+void
+sa_index_close(saindex_t *index) {
+  if(index == NULL) { return; }
+  sa_munmap(index->map, index->mapsize);
+  memset(index, 0, sizeof(saindex_t));
+}
@@ -0,0 +1,111 @@
+/*
+ * mapfile.c for libdivsufsort
+ * Copyright (c) 2003-2008 Yuta Mori All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "divsufsort_private.h"
+#if HAVE_MMAP
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+
+/*- Functions -*/
+
+/* Maps a file into memory for reading. */
+saint_t
+sa_mmap(const char *filename, saint_t flags, void **addr, size_t *size) {
+#if HAVE_MMAP
+  struct stat st;
+  void *p;
+  int fd, mflags;
+
+  if((filename == NULL) || (addr == NULL) || (size == NULL)) { return -1; }
+  *addr = NULL, *size = 0;
+
+  if((fd = open(filename, O_RDONLY)) < 0) { return -1; }
+  if(fstat(fd, &st) != 0) { close(fd); return -1; }
+  if(st.st_size == 0) { close(fd); return 0; }
+  if((off_t)(size_t)st.st_size != st.st_size) { close(fd); return -1; }
+
+  mflags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+  if(flags & SA_MMAP_POPULATE) { mflags |= MAP_POPULATE; }
+#endif
+  p = mmap(NULL, (size_t)st.st_size, PROT_READ, mflags, fd, 0);
+  close(fd);
+  if(p == MAP_FAILED) { return -1; }
+
+  /* The hints are advisory, so their failures are ignored. */
+#if defined(MADV_WILLNEED) && !defined(MAP_POPULATE)
+  if(flags & SA_MMAP_POPULATE) { madvise(p, (size_t)st.st_size, MADV_WILLNEED); }
+#endif
+#if defined(MADV_RANDOM)
+  if(flags & SA_MMAP_RANDOM) { madvise(p, (size_t)st.st_size, MADV_RANDOM); }
+#endif
+#if defined(MADV_SEQUENTIAL)
+  if(flags & SA_MMAP_SEQUENTIAL) { madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL); }
+#endif
+
+  *addr = p, *size = (size_t)st.st_size;
+  return 0;
+#else
+  /* Falls back to reading the whole file. */
+  FILE *fp;
+  void *p;
+  long n;
+
+  (void)flags;
+  if((filename == NULL) || (addr == NULL) || (size == NULL)) { return -1; }
+  *addr = NULL, *size = 0;
+
+  if((fp = fopen(filename, "rb")) == NULL) { return -1; }
+  if((fseek(fp, 0, SEEK_END) != 0) || ((n = ftell(fp)) < 0)) { fclose(fp); return -1; }
+  rewind(fp);
+  if(n == 0) { fclose(fp); return 0; }
+  if((p = malloc((size_t)n)) == NULL) { fclose(fp); return -2; }
+  if(fread(p, 1, (size_t)n, fp) != (size_t)n) { free(p); fclose(fp); return -1; }
+  fclose(fp);
+
+  *addr = p, *size = (size_t)n;
+  return 0;
+#endif
+}
+
+/* Unmaps a file mapped by sa_mmap. */
+saint_t
+sa_munmap(void *addr, size_t size) {
+  if(addr == NULL) { return 0; }
+#if HAVE_MMAP
+  return (munmap(addr, size) == 0) ? 0 : -1;
+#else
+  (void)size;
+  free(addr);
+  return 0;
+#endif
+}
@@ -25,6 +25,9 @@
  */
 
 #include "divsufsort_private.h"
+#ifdef _OPENMP
+# include <omp.h>
+#endif
 
 
 /*- Private Functions -*/
@@ -40,13 +43,10 @@ static const saint_t lg_table[256]= {
   7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7
 };
 
-#if (SS_BLOCKSIZE == 0) || (SS_INSERTIONSORT_THRESHOLD < SS_BLOCKSIZE)
-
 static INLINE
 saint_t
 ss_ilg(saidx_t n) {
-#if SS_BLOCKSIZE == 0
-# if defined(BUILD_DIVSUFSORT64)
+#if defined(BUILD_DIVSUFSORT64)
   return (n >> 32) ?
           ((n >> 48) ?
             ((n >> 56) ?
@@ -62,7 +62,7 @@ ss_ilg(saidx_t n) {
             ((n & 0x0000ff00) ?
                8 + lg_table[(n >>  8) & 0xff] :
                0 + lg_table[(n >>  0) & 0xff]));
-# else
+#else
   return (n & 0xffff0000) ?
           ((n & 0xff000000) ?
             24 + lg_table[(n >> 24) & 0xff] :
@@ -70,20 +70,9 @@ ss_ilg(saidx_t n) {
           ((n & 0x0000ff00) ?
              8 + lg_table[(n >>  8) & 0xff] :
              0 + lg_table[(n >>  0) & 0xff]);
-# endif
-#elif SS_BLOCKSIZE < 256
-  return lg_table[n];
-#else
-  return (n & 0xff00) ?
-          8 + lg_table[(n >> 8) & 0xff] :
-          0 + lg_table[(n >> 0) & 0xff];
 #endif
 }
 
-#endif /* (SS_BLOCKSIZE == 0) || (SS_INSERTIONSORT_THRESHOLD < SS_BLOCKSIZE) */
-
-#if SS_BLOCKSIZE != 0
-
 static const saint_t sqq_table[256] = {
   0,  16,  22,  27,  32,  35,  39,  42,  45,  48,  50,  53,  55,  57,  59,  61,
  64,  65,  67,  69,  71,  73,  75,  76,  78,  80,  81,  83,  84,  86,  87,  89,
@@ -105,10 +94,10 @@ static const saint_t sqq_table[256] = {
 
 static INLINE
 saidx_t
-ss_isqrt(saidx_t x) {
+ss_isqrt(saidx_t x, saidx_t blocksize) {
   saidx_t y, e;
 
-  if(x >= (SS_BLOCKSIZE * SS_BLOCKSIZE)) { return SS_BLOCKSIZE; }
+  if(x >= (blocksize * blocksize)) { return blocksize; }
   e = (x & 0xffff0000) ?
         ((x & 0xff000000) ?
           24 + lg_table[(x >> 24) & 0xff] :
@@ -130,8 +119,6 @@ ss_isqrt(saidx_t x) {
   return (x < (y * y)) ? y - 1 : y;
 }
 
-#endif /* SS_BLOCKSIZE != 0 */
-
 
 /*---------------------------------------------------------------------------*/
 
@@ -142,25 +129,25 @@ ss_compare(const sauchar_t *T,
            const saidx_t *p1, const saidx_t *p2,
            saidx_t depth) {
   const sauchar_t *U1, *U2, *U1n, *U2n;
-
-  for(U1 = T + depth + *p1,
-      U2 = T + depth + *p2,
-      U1n = T + *(p1 + 1) + 2,
-      U2n = T + *(p2 + 1) + 2;
-      (U1 < U1n) && (U2 < U2n) && (*U1 == *U2);
-      ++U1, ++U2) {
+  saidx_t l;
+
+  U1 = T + depth + *p1,
+  U2 = T + depth + *p2,
+  U1n = T + *(p1 + 1) + 2,
+  U2n = T + *(p2 + 1) + 2;
+  if((U1 < U1n) && (U2 < U2n) && (*U1 == *U2)) {
+    l = memlcp(U1, U2, MIN(U1n - U1, U2n - U2));
+    U1 += l, U2 += l;
   }
 
-  return U1 < U1n ?
-        (U2 < U2n ? *U1 - *U2 : 1) :
-        (U2 < U2n ? -1 : 0);
+  return SA_COMPARE(U1 < U1n ?
+                    (U2 < U2n ? *U1 - *U2 : 1) :
+                    (U2 < U2n ? -1 : 0));
 }
 
 
 /*---------------------------------------------------------------------------*/
 
-#if (SS_BLOCKSIZE != 1) && (SS_INSERTIONSORT_THRESHOLD != 1)
-
 /* Insertionsort for small size groups */
 static
 void
@@ -180,13 +167,68 @@ ss_insertionsort(const sauchar_t *T, const saidx_t *PA,
   }
 }
 
-#endif /* (SS_BLOCKSIZE != 1) && (SS_INSERTIONSORT_THRESHOLD != 1) */
+/* Packs up to 7 characters of a substring from depth on into the high
+   bytes of a key, and their number into the low byte. Keys order as the
+   substrings do, except that equal keys with 7 characters are undecided. */
+static INLINE
+uint64_t
+ss_packkey(const sauchar_t *T, const saidx_t *PA, saidx_t t, saidx_t depth) {
+  const sauchar_t *U = T + depth + PA[t];
+  saidx_t i, l = T + PA[t + 1] + 2 - U;
+  uint64_t x = 0;
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && \
+    (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  if(8 <= l) {
+    memcpy(&x, U, 8);
+    return (__builtin_bswap64(x) & ~(uint64_t)0xff) | 7;
+  }
+#endif
+  for(i = 0, l = MIN(l, 7); i < l; ++i) { x = (x << 8) | U[i]; }
+  for(; i < 7; ++i) { x <<= 8; }
+  return (x << 8) | (uint64_t)MAX(l, 0);
+}
+
+/* Sorting network for groups of up to SORTNET_SIZE. The keys are gathered
+   once and sorted branchlessly; only runs of undecided keys are compared
+   in full. */
+static
+void
+ss_leafsort(const sauchar_t *T, const saidx_t *PA,
+            saidx_t *first, saidx_t *last, saidx_t depth) {
+#define SS_CSWAP(_i, _j)\
+  do {\
+    c = SA_COMPARE(K[(_j)] < K[(_i)]);\
+    k0 = K[(_i)], k1 = K[(_j)], v0 = V[(_i)], v1 = V[(_j)];\
+    K[(_i)] = c ? k1 : k0, K[(_j)] = c ? k0 : k1;\
+    V[(_i)] = c ? v1 : v0, V[(_j)] = c ? v0 : v1;\
+  } while(0)
+  uint64_t K[SORTNET_SIZE], k0, k1;
+  saidx_t V[SORTNET_SIZE], v0, v1;
+  saidx_t i, j, n = last - first;
+  saint_t c;
+
+  for(i = 0; i < n; ++i) { K[i] = ss_packkey(T, PA, V[i] = first[i], depth); }
+  for(; i < SORTNET_SIZE; ++i) { K[i] = ~(uint64_t)0, V[i] = 0; }
+  SORTNET8(SS_CSWAP);
+  for(i = 0; i < n; ++i) { first[i] = V[i]; }
+
+  /* Mark ties, and settle undecided runs. */
+  for(i = 0; i < n; i = j) {
+    for(j = i + 1; (j < n) && (K[j] == K[i]); ++j) { }
+    if((j - i) < 2) { continue; }
+    if((K[i] & 0xff) == 7) {
+      ss_insertionsort(T, PA, first + i, first + j, depth + 7);
+    } else {
+      for(v0 = i + 1; v0 < j; ++v0) { first[v0] = ~first[v0]; }
+    }
+  }
+#undef SS_CSWAP
+}
 
 
 /*---------------------------------------------------------------------------*/
 
-#if (SS_BLOCKSIZE == 0) || (SS_INSERTIONSORT_THRESHOLD < SS_BLOCKSIZE)
-
 static INLINE
 void
 ss_fixdown(const sauchar_t *Td, const saidx_t *PA,
@@ -197,8 +239,8 @@ ss_fixdown(const sauchar_t *Td, const saidx_t *PA,
 
   for(v = SA[i], c = Td[PA[v]]; (j = 2 * i + 1) < size; SA[i] = SA[k], i = k) {
     d = Td[PA[SA[k = j++]]];
-    if(d < (e = Td[PA[SA[j]]])) { k = j; d = e; }
-    if(d <= c) { break; }
+    if(SA_COMPARE(d < (e = Td[PA[SA[j]]]))) { k = j; d = e; }
+    if(SA_COMPARE(d <= c)) { break; }
   }
   SA[i] = v;
 }
@@ -213,7 +255,7 @@ ss_heapsort(const sauchar_t *Td, const saidx_t *PA, saidx_t *SA, saidx_t size) {
   m = size;
   if((size % 2) == 0) {
     m--;
-    if(Td[PA[SA[m / 2]]] < Td[PA[SA[m]]]) { SWAP(SA[m], SA[m / 2]); }
+    if(SA_COMPARE(Td[PA[SA[m / 2]]] < Td[PA[SA[m]]])) { SWAP(SA[m], SA[m / 2]); }
   }
 
   for(i = m / 2 - 1; 0 <= i; --i) { ss_fixdown(Td, PA, SA, i, m); }
@@ -234,9 +276,9 @@ saidx_t *
 ss_median3(const sauchar_t *Td, const saidx_t *PA,
            saidx_t *v1, saidx_t *v2, saidx_t *v3) {
   saidx_t *t;
-  if(Td[PA[*v1]] > Td[PA[*v2]]) { SWAP(v1, v2); }
-  if(Td[PA[*v2]] > Td[PA[*v3]]) {
-    if(Td[PA[*v1]] > Td[PA[*v3]]) { return v1; }
+  if(SA_COMPARE(Td[PA[*v1]] > Td[PA[*v2]])) { SWAP(v1, v2); }
+  if(SA_COMPARE(Td[PA[*v2]] > Td[PA[*v3]])) {
+    if(SA_COMPARE(Td[PA[*v1]] > Td[PA[*v3]])) { return v1; }
     else { return v3; }
   }
   return v2;
@@ -248,12 +290,12 @@ saidx_t *
 ss_median5(const sauchar_t *Td, const saidx_t *PA,
            saidx_t *v1, saidx_t *v2, saidx_t *v3, saidx_t *v4, saidx_t *v5) {
   saidx_t *t;
-  if(Td[PA[*v2]] > Td[PA[*v3]]) { SWAP(v2, v3); }
-  if(Td[PA[*v4]] > Td[PA[*v5]]) { SWAP(v4, v5); }
-  if(Td[PA[*v2]] > Td[PA[*v4]]) { SWAP(v2, v4); SWAP(v3, v5); }
-  if(Td[PA[*v1]] > Td[PA[*v3]]) { SWAP(v1, v3); }
-  if(Td[PA[*v1]] > Td[PA[*v4]]) { SWAP(v1, v4); SWAP(v3, v5); }
-  if(Td[PA[*v3]] > Td[PA[*v4]]) { return v4; }
+  if(SA_COMPARE(Td[PA[*v2]] > Td[PA[*v3]])) { SWAP(v2, v3); }
+  if(SA_COMPARE(Td[PA[*v4]] > Td[PA[*v5]])) { SWAP(v4, v5); }
+  if(SA_COMPARE(Td[PA[*v2]] > Td[PA[*v4]])) { SWAP(v2, v4); SWAP(v3, v5); }
+  if(SA_COMPARE(Td[PA[*v1]] > Td[PA[*v3]])) { SWAP(v1, v3); }
+  if(SA_COMPARE(Td[PA[*v1]] > Td[PA[*v4]])) { SWAP(v1, v4); SWAP(v3, v5); }
+  if(SA_COMPARE(Td[PA[*v3]] > Td[PA[*v4]])) { return v4; }
   return v3;
 }
 
@@ -304,12 +346,98 @@ ss_partition(const saidx_t *PA,
   return a;
 }
 
-/* Multikey introsort for medium size groups. */
+/* Returns the number of characters after depth for which every substring
+   of [first, last) repeats its character at depth, i.e. the part of a run
+   the whole group is still in. A run holds no substring end, so the group
+   can skip it in one step instead of partitioning once per character. */
+static INLINE
+saidx_t
+ss_runlength(const sauchar_t *T, const saidx_t *PA,
+             const saidx_t *first, const saidx_t *last, saidx_t depth) {
+  const sauchar_t *U;
+  saidx_t k, l;
+
+  U = T + PA[*first] + depth;
+  k = memlcp(U, U + 1, PA[*first + 1] + 1 - (PA[*first] + depth));
+  for(++first; (0 < k) && (first < last); ++first) {
+    U = T + PA[*first] + depth;
+    if((l = PA[*first + 1] + 1 - (PA[*first] + depth)) < k) { k = l; }
+    k = memlcp(U, U + 1, k);
+  }
+  return k;
+}
+
+#if SS_RADIX_THRESHOLD != 0
+
+static void ss_mintrosort(const sauchar_t *T, const saidx_t *PA,
+                          saidx_t *first, saidx_t *last, saidx_t depth,
+                          saidx_t threshold);
+
+/* MSD radix step for large groups. Distributes [first, last) by the
+   character at depth in place, then sorts every bucket but the largest at
+   depth + 1 and leaves that one in [*pfirst, *plast) for the caller.
+   Returns 0, having done nothing, if all the characters are equal. */
+static
+saint_t
+ss_radixsort(const sauchar_t *T, const saidx_t *PA,
+             saidx_t **pfirst, saidx_t **plast, saidx_t depth,
+             saidx_t threshold) {
+  saidx_t bucket[ALPHABET_SIZE + 1], next[ALPHABET_SIZE];
+  sauchar_t key[SS_RADIX_MAXSIZE];
+  const sauchar_t *Td = T + depth;
+  saidx_t *first = *pfirst, *last = *plast, *a, *b, *c;
+  saidx_t i, j, t, u, size = last - first;
+  saint_t v, x, y;
+
+  /* Gather the characters once, counting them. */
+  for(v = 0; v < ALPHABET_SIZE; ++v) { bucket[v] = 0; }
+  for(i = 0; i < size; ++i) { ++bucket[key[i] = Td[PA[first[i]]]]; }
+  if(bucket[key[0]] == size) { return 0; }
+  for(v = 0, i = 0; v < ALPHABET_SIZE; ++v) {
+    t = bucket[v], bucket[v] = next[v] = i, i += t;
+  }
+  bucket[ALPHABET_SIZE] = size;
+
+  /* Permute in place, following each cycle until it closes. */
+  for(v = 0; v < ALPHABET_SIZE; ++v) {
+    for(; next[v] < bucket[v + 1]; ++next[v]) {
+      for(t = first[next[v]], x = key[next[v]]; x != v; t = u, x = y) {
+        j = next[x]++;
+        u = first[j], y = key[j];
+        first[j] = t;
+      }
+      first[next[v]] = t;
+    }
+  }
+
+  /* Sort the buckets. As in the equal group of a partition, substrings
+     ending at depth go to the front of their bucket as a tie. */
+  *pfirst = *plast = first;
+  for(v = 0; v < ALPHABET_SIZE; ++v) {
+    a = first + bucket[v], c = first + bucket[v + 1];
+    if((c - a) < 2) { continue; }
+    b = SA_COMPARE(v <= Td[PA[*a] - 1]) ? a : ss_partition(PA, a, c, depth);
+    if((*plast - *pfirst) < (c - b)) {
+      if(1 < (*plast - *pfirst)) { ss_mintrosort(T, PA, *pfirst, *plast, depth + 1, threshold); }
+      *pfirst = b, *plast = c;
+    } else if(1 < (c - b)) {
+      ss_mintrosort(T, PA, b, c, depth + 1, threshold);
+    }
+  }
+  return 1;
+}
+
+#endif /* SS_RADIX_THRESHOLD != 0 */
+
+/* Multikey introsort for medium size groups. Groups of
+   SS_RADIX_THRESHOLD to SS_RADIX_MAXSIZE suffixes are split by an MSD
+   radix step instead of a pivot; groups of up to threshold suffixes are
+   left to the leaf sorts. */
 static
 void
 ss_mintrosort(const sauchar_t *T, const saidx_t *PA,
               saidx_t *first, saidx_t *last,
-              saidx_t depth) {
+              saidx_t depth, saidx_t threshold) {
 #define STACK_SIZE SS_MISORT_STACKSIZE
   struct { saidx_t *a, *b, c; saint_t d; } stack[STACK_SIZE];
   const sauchar_t *Td;
@@ -321,25 +449,36 @@ ss_mintrosort(const sauchar_t *T, const saidx_t *PA,
 
   for(ssize = 0, limit = ss_ilg(last - first);;) {
 
-    if((last - first) <= SS_INSERTIONSORT_THRESHOLD) {
-#if 1 < SS_INSERTIONSORT_THRESHOLD
-      if(1 < (last - first)) { ss_insertionsort(T, PA, first, last, depth); }
-#endif
+    if((last - first) <= threshold) {
+      if((last - first) <= SORTNET_SIZE) {
+        if(1 < (last - first)) { ss_leafsort(T, PA, first, last, depth); }
+      } else {
+        ss_insertionsort(T, PA, first, last, depth);
+      }
       STACK_POP(first, last, depth, limit);
       continue;
     }
 
+#if SS_RADIX_THRESHOLD != 0
+    if((SS_RADIX_THRESHOLD <= (last - first)) && ((last - first) <= SS_RADIX_MAXSIZE) &&
+       (0 < limit) &&
+       (ss_radixsort(T, PA, &first, &last, depth, threshold) != 0)) {
+      depth += 1, limit = ss_ilg(last - first);
+      continue;
+    }
+#endif
+
     Td = T + depth;
     if(limit-- == 0) { ss_heapsort(Td, PA, first, last - first); }
     if(limit < 0) {
       for(a = first + 1, v = Td[PA[*first]]; a < last; ++a) {
-        if((x = Td[PA[*a]]) != v) {
+        if(SA_COMPARE((x = Td[PA[*a]]) != v)) {
           if(1 < (a - first)) { break; }
           v = x;
           first = a;
         }
       }
-      if(Td[PA[*first] - 1] < v) {
+      if(SA_COMPARE(Td[PA[*first] - 1] < v)) {
         first = ss_partition(PA, first, a, depth);
       }
       if((a - first) <= (last - a)) {
@@ -366,24 +505,24 @@ ss_mintrosort(const sauchar_t *T, const saidx_t *PA,
     SWAP(*first, *a);
 
     /* partition */
-    for(b = first; (++b < last) && ((x = Td[PA[*b]]) == v);) { }
+    for(b = first; (++b < last) && SA_COMPARE((x = Td[PA[*b]]) == v);) { }
     if(((a = b) < last) && (x < v)) {
-      for(; (++b < last) && ((x = Td[PA[*b]]) <= v);) {
+      for(; (++b < last) && SA_COMPARE((x = Td[PA[*b]]) <= v);) {
         if(x == v) { SWAP(*b, *a); ++a; }
       }
     }
-    for(c = last; (b < --c) && ((x = Td[PA[*c]]) == v);) { }
+    for(c = last; (b < --c) && SA_COMPARE((x = Td[PA[*c]]) == v);) { }
     if((b < (d = c)) && (x > v)) {
-      for(; (b < --c) && ((x = Td[PA[*c]]) >= v);) {
+      for(; (b < --c) && SA_COMPARE((x = Td[PA[*c]]) >= v);) {
         if(x == v) { SWAP(*c, *d); --d; }
       }
     }
     for(; b < c;) {
       SWAP(*b, *c);
-      for(; (++b < c) && ((x = Td[PA[*b]]) <= v);) {
+      for(; (++b < c) && SA_COMPARE((x = Td[PA[*b]]) <= v);) {
         if(x == v) { SWAP(*b, *a); ++a; }
       }
-      for(; (b < --c) && ((x = Td[PA[*c]]) >= v);) {
+      for(; (b < --c) && SA_COMPARE((x = Td[PA[*c]]) >= v);) {
         if(x == v) { SWAP(*c, *d); --d; }
       }
     }
@@ -397,7 +536,7 @@ ss_mintrosort(const sauchar_t *T, const saidx_t *PA,
       for(e = b, f = last - s; 0 < s; --s, ++e, ++f) { SWAP(*e, *f); }
 
       a = first + (b - a), c = last - (d - c);
-      b = (v <= Td[PA[*a] - 1]) ? a : ss_partition(PA, a, c, depth);
+      b = SA_COMPARE(v <= Td[PA[*a] - 1]) ? a : ss_partition(PA, a, c, depth);
 
       if((a - first) <= (last - c)) {
         if((last - c) <= (c - b)) {
@@ -430,23 +569,22 @@ ss_mintrosort(const sauchar_t *T, const saidx_t *PA,
       }
     } else {
       limit += 1;
-      if(Td[PA[*first] - 1] < v) {
+      if(SA_COMPARE(Td[PA[*first] - 1] < v)) {
         first = ss_partition(PA, first, last, depth);
         limit = ss_ilg(last - first);
       }
+      if((threshold < (last - first)) && SA_COMPARE(Td[PA[*first] + 1] == v)) {
+        depth += ss_runlength(T, PA, first, last, depth);
+      }
       depth += 1;
     }
   }
 #undef STACK_SIZE
 }
 
-#endif /* (SS_BLOCKSIZE == 0) || (SS_INSERTIONSORT_THRESHOLD < SS_BLOCKSIZE) */
-
 
 /*---------------------------------------------------------------------------*/
 
-#if SS_BLOCKSIZE != 0
-
 static INLINE
 void
 ss_blockswap(saidx_t *a, saidx_t *b, saidx_t n) {
@@ -735,7 +873,56 @@ ss_swapmerge(const sauchar_t *T, const saidx_t *PA,
 #undef STACK_SIZE
 }
 
-#endif /* SS_BLOCKSIZE != 0 */
+#if defined(_OPENMP)
+/* Returns 1 if sssort sorts a group of size suffixes, given bufsize of
+   buffer, on nthreads threads with ss_parallelsort, and 0 if it sorts it on
+   one thread. */
+saint_t
+ss_isparallel(const sactx_t *ctx, saidx_t size, saidx_t bufsize, saint_t nthreads) {
+  saidx_t blocksize = ctx->tuning->ss_blocksize;
+  return (saint_t)((blocksize != 0) && (1 < nthreads) &&
+                   ((blocksize * SS_PARALLEL_BLOCKS) <= size) &&
+                   ((blocksize * nthreads) <= bufsize));
+}
+
+/* Parallel blockwise sort. The blocks are sorted concurrently, then runs of
+   k blocks are merged pairwise, level by level, each thread merging with
+   its own slice of buf; the slices grow as the runs become fewer. Sorted
+   blocks are reported to the progress callback, and once the sort is
+   cancelled the remaining blocks and merges are skipped. */
+static
+void
+ss_parallelsort(const sauchar_t *T, const saidx_t *PA,
+                saidx_t *first, saidx_t *last,
+                saidx_t *buf, saidx_t bufsize,
+                saidx_t depth, saidx_t blocksize, saidx_t threshold,
+                saint_t nthreads, sactx_t *ctx) {
+  saidx_t *a, *b, *c;
+  saidx_t i, k, n = last - first, nruns, t, size;
+
+  nruns = (n - 1) / blocksize + 1;
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads) default(shared) private(i, a, b)
+  for(i = 0; i < nruns; ++i) {
+    a = first + i * blocksize, b = (i < (nruns - 1)) ? a + blocksize : last;
+    if(ctx->cancelled == 0) {
+      ss_mintrosort(T, PA, a, b, depth, threshold);
+      if(ctx->progress != NULL) { progress_report(ctx, b - a); }
+    }
+  }
+  for(k = blocksize; k < n; k <<= 1) {
+    nruns = (n - 1) / (2 * k) + 1;
+    t = MIN(nthreads, nruns), size = bufsize / t;
+#pragma omp parallel for schedule(dynamic, 1) num_threads(t) default(shared) private(i, a, b, c)
+    for(i = 0; i < nruns; ++i) {
+      a = first + i * 2 * k, b = a + k, c = (i < (nruns - 1)) ? b + k : last;
+      if((b < c) && (ctx->cancelled == 0)) {
+        ss_swapmerge(T, PA, a, b, c,
+                     buf + omp_get_thread_num() * size, size, depth);
+      }
+    }
+  }
+}
+#endif /* defined(_OPENMP) */
 
 
 /*---------------------------------------------------------------------------*/
@@ -747,60 +934,65 @@ void
 sssort(const sauchar_t *T, const saidx_t *PA,
        saidx_t *first, saidx_t *last,
        saidx_t *buf, saidx_t bufsize,
-       saidx_t depth, saidx_t n, saint_t lastsuffix) {
-  saidx_t *a;
-#if SS_BLOCKSIZE != 0
-  saidx_t *b, *middle, *curbuf;
-  saidx_t j, k, curbufsize, limit;
-#endif
-  saidx_t i;
+       saidx_t depth, saidx_t n, saint_t lastsuffix,
+       sactx_t *ctx) {
+  saidx_t *a, *b, *middle, *curbuf;
+  saidx_t i, j, k, curbufsize, limit, size = last - first, w = 0;
+  saidx_t blocksize = ctx->tuning->ss_blocksize;
+  saidx_t threshold = ctx->tuning->ss_insertionsort_threshold;
 
   if(lastsuffix != 0) { ++first; }
 
-#if SS_BLOCKSIZE == 0
-  ss_mintrosort(T, PA, first, last, depth);
-#else
-  if((bufsize < SS_BLOCKSIZE) &&
-      (bufsize < (last - first)) &&
-      (bufsize < (limit = ss_isqrt(last - first)))) {
-    if(SS_BLOCKSIZE < limit) { limit = SS_BLOCKSIZE; }
-    buf = middle = last - limit, bufsize = limit;
-  } else {
-    middle = last, limit = 0;
-  }
-  for(a = first, i = 0; SS_BLOCKSIZE < (middle - a); a += SS_BLOCKSIZE, ++i) {
-#if SS_INSERTIONSORT_THRESHOLD < SS_BLOCKSIZE
-    ss_mintrosort(T, PA, a, a + SS_BLOCKSIZE, depth);
-#elif 1 < SS_BLOCKSIZE
-    ss_insertionsort(T, PA, a, a + SS_BLOCKSIZE, depth);
+  if(blocksize == 0) {
+    ss_mintrosort(T, PA, first, last, depth, threshold);
+#if defined(_OPENMP)
+  } else if((omp_in_parallel() == 0) &&
+            (ss_isparallel(ctx, last - first, bufsize, (saint_t)(i = omp_get_max_threads())) != 0)) {
+    ss_parallelsort(T, PA, first, last, buf, bufsize,
+                    depth, blocksize, threshold, (saint_t)i, ctx);
+    if(ctx->cancelled != 0) { return; }
+    size -= last - first;
 #endif
-    curbufsize = last - (a + SS_BLOCKSIZE);
-    curbuf = a + SS_BLOCKSIZE;
-    if(curbufsize <= bufsize) { curbufsize = bufsize, curbuf = buf; }
-    for(b = a, k = SS_BLOCKSIZE, j = i; j & 1; b -= k, k <<= 1, j >>= 1) {
-      ss_swapmerge(T, PA, b - k, b, b + k, curbuf, curbufsize, depth);
+  } else {
+    if((bufsize < blocksize) &&
+        (bufsize < (last - first)) &&
+        (bufsize < (limit = ss_isqrt(last - first, blocksize)))) {
+      if(blocksize < limit) { limit = blocksize; }
+      buf = middle = last - limit, bufsize = limit;
+    } else {
+      middle = last, limit = 0;
     }
-  }
-#if SS_INSERTIONSORT_THRESHOLD < SS_BLOCKSIZE
-  ss_mintrosort(T, PA, a, middle, depth);
-#elif 1 < SS_BLOCKSIZE
-  ss_insertionsort(T, PA, a, middle, depth);
-#endif
-  for(k = SS_BLOCKSIZE; i != 0; k <<= 1, i >>= 1) {
-    if(i & 1) {
-      ss_swapmerge(T, PA, a - k, a, middle, buf, bufsize, depth);
-      a -= k;
+    for(a = first, i = 0; blocksize < (middle - a); a += blocksize, ++i) {
+      ss_mintrosort(T, PA, a, a + blocksize, depth, threshold);
+      curbufsize = last - (a + blocksize);
+      curbuf = a + blocksize;
+      if(curbufsize <= bufsize) { curbufsize = bufsize, curbuf = buf; }
+      for(b = a, k = blocksize, j = i; j & 1; b -= k, k <<= 1, j >>= 1) {
+        ss_swapmerge(T, PA, b - k, b, b + k, curbuf, curbufsize, depth);
+      }
+      if((ctx->progress != NULL) && (SA_PROGRESS_INTERVAL <= (w += blocksize))) {
+        if(progress_report(ctx, w) != 0) { return; }
+        size -= w, w = 0;
+      }
     }
-  }
-  if(limit != 0) {
-#if SS_INSERTIONSORT_THRESHOLD < SS_BLOCKSIZE
-    ss_mintrosort(T, PA, middle, last, depth);
-#elif 1 < SS_BLOCKSIZE
-    ss_insertionsort(T, PA, middle, last, depth);
+    ss_mintrosort(T, PA, a, middle, depth, threshold);
+    for(k = blocksize; i != 0; k <<= 1, i >>= 1) {
+      if(i & 1) {
+        ss_swapmerge(T, PA, a - k, a, middle, buf, bufsize, depth);
+        a -= k;
+      }
+    }
+    if(limit != 0) {
+      ss_mintrosort(T, PA, middle, last, depth, threshold);
+      ss_inplacemerge(T, PA, first, middle, last, depth);
+      if(ctx->stats != NULL) {
+#if defined(_OPENMP)
+#pragma omp atomic
 #endif
-    ss_inplacemerge(T, PA, first, middle, last, depth);
+        ++ctx->stats->ss_inplacemerges;
+      }
+    }
   }
-#endif
 
   if(lastsuffix != 0) {
     /* Insert last type B* suffix. */
@@ -812,4 +1004,38 @@ sssort(const sauchar_t *T, const saidx_t *PA,
     }
     *(a - 1) = i;
   }
+
+  if(ctx->progress != NULL) { progress_report(ctx, size); }
+}
+
+
+/*---------------------------------------------------------------------------*/
+
+/*- Test hooks -*/
+
+#if defined(SA_TEST_HOOKS)
+
+uint64_t sa_test_compares = 0;
+
+void
+ss_test_mintrosort(const sauchar_t *T, const saidx_t *PA,
+                   saidx_t *first, saidx_t *last,
+                   saidx_t depth, saidx_t threshold) {
+  ss_mintrosort(T, PA, first, last, depth, threshold);
+}
+
+void
+ss_test_swapmerge(const sauchar_t *T, const saidx_t *PA,
+                  saidx_t *first, saidx_t *middle, saidx_t *last,
+                  saidx_t *buf, saidx_t bufsize, saidx_t depth) {
+  ss_swapmerge(T, PA, first, middle, last, buf, bufsize, depth);
+}
+
+void
+ss_test_inplacemerge(const sauchar_t *T, const saidx_t *PA,
+                     saidx_t *first, saidx_t *middle, saidx_t *last,
+                     saidx_t depth) {
+  ss_inplacemerge(T, PA, first, middle, last, depth);
 }
+
+#endif /* defined(SA_TEST_HOOKS) */
@@ -81,7 +81,7 @@ tr_insertionsort(const saidx_t *ISAd, saidx_t *first, saidx_t *last) {
   saidx_t t, r;
 
   for(a = first + 1; a < last; ++a) {
-    for(t = *a, b = a - 1; 0 > (r = ISAd[t] - ISAd[*b]);) {
+    for(t = *a, b = a - 1; 0 > (r = SA_COMPARE(ISAd[t] - ISAd[*b]));) {
       do { *(b + 1) = *b; } while((first <= --b) && (*b < 0));
       if(b < first) { break; }
     }
@@ -91,6 +91,30 @@ tr_insertionsort(const saidx_t *ISAd, saidx_t *first, saidx_t *last) {
 }
 
 
+/* Sorting network for groups of up to SORTNET_SIZE. The ranks are
+   gathered once and sorted branchlessly, then ties are marked. */
+static
+void
+tr_leafsort(const saidx_t *ISAd, saidx_t *first, saidx_t *last) {
+#define TR_CSWAP(_i, _j)\
+  do {\
+    c = SA_COMPARE(K[(_j)] < K[(_i)]);\
+    k0 = K[(_i)], k1 = K[(_j)], v0 = V[(_i)], v1 = V[(_j)];\
+    K[(_i)] = c ? k1 : k0, K[(_j)] = c ? k0 : k1;\
+    V[(_i)] = c ? v1 : v0, V[(_j)] = c ? v0 : v1;\
+  } while(0)
+  saidx_t K[SORTNET_SIZE], V[SORTNET_SIZE];
+  saidx_t i, n = last - first, k0, k1, v0, v1;
+  saint_t c;
+
+  for(i = 0; i < n; ++i) { K[i] = ISAd[V[i] = first[i]]; }
+  for(; i < SORTNET_SIZE; ++i) { K[i] = SAIDX_MAX, V[i] = 0; }
+  SORTNET8(TR_CSWAP);
+  for(i = 0; i < (n - 1); ++i) { first[i] = (K[i] == K[i + 1]) ? ~V[i] : V[i]; }
+  first[i] = V[i];
+#undef TR_CSWAP
+}
+
 /*---------------------------------------------------------------------------*/
 
 static INLINE
@@ -102,8 +126,8 @@ tr_fixdown(const saidx_t *ISAd, saidx_t *SA, saidx_t i, saidx_t size) {
 
   for(v = SA[i], c = ISAd[v]; (j = 2 * i + 1) < size; SA[i] = SA[k], i = k) {
     d = ISAd[SA[k = j++]];
-    if(d < (e = ISAd[SA[j]])) { k = j; d = e; }
-    if(d <= c) { break; }
+    if(SA_COMPARE(d < (e = ISAd[SA[j]]))) { k = j; d = e; }
+    if(SA_COMPARE(d <= c)) { break; }
   }
   SA[i] = v;
 }
@@ -118,7 +142,7 @@ tr_heapsort(const saidx_t *ISAd, saidx_t *SA, saidx_t size) {
   m = size;
   if((size % 2) == 0) {
     m--;
-    if(ISAd[SA[m / 2]] < ISAd[SA[m]]) { SWAP(SA[m], SA[m / 2]); }
+    if(SA_COMPARE(ISAd[SA[m / 2]] < ISAd[SA[m]])) { SWAP(SA[m], SA[m / 2]); }
   }
 
   for(i = m / 2 - 1; 0 <= i; --i) { tr_fixdown(ISAd, SA, i, m); }
@@ -138,9 +162,9 @@ static INLINE
 saidx_t *
 tr_median3(const saidx_t *ISAd, saidx_t *v1, saidx_t *v2, saidx_t *v3) {
   saidx_t *t;
-  if(ISAd[*v1] > ISAd[*v2]) { SWAP(v1, v2); }
-  if(ISAd[*v2] > ISAd[*v3]) {
-    if(ISAd[*v1] > ISAd[*v3]) { return v1; }
+  if(SA_COMPARE(ISAd[*v1] > ISAd[*v2])) { SWAP(v1, v2); }
+  if(SA_COMPARE(ISAd[*v2] > ISAd[*v3])) {
+    if(SA_COMPARE(ISAd[*v1] > ISAd[*v3])) { return v1; }
     else { return v3; }
   }
   return v2;
@@ -152,12 +176,12 @@ saidx_t *
 tr_median5(const saidx_t *ISAd,
            saidx_t *v1, saidx_t *v2, saidx_t *v3, saidx_t *v4, saidx_t *v5) {
   saidx_t *t;
-  if(ISAd[*v2] > ISAd[*v3]) { SWAP(v2, v3); }
-  if(ISAd[*v4] > ISAd[*v5]) { SWAP(v4, v5); }
-  if(ISAd[*v2] > ISAd[*v4]) { SWAP(v2, v4); SWAP(v3, v5); }
-  if(ISAd[*v1] > ISAd[*v3]) { SWAP(v1, v3); }
-  if(ISAd[*v1] > ISAd[*v4]) { SWAP(v1, v4); SWAP(v3, v5); }
-  if(ISAd[*v3] > ISAd[*v4]) { return v4; }
+  if(SA_COMPARE(ISAd[*v2] > ISAd[*v3])) { SWAP(v2, v3); }
+  if(SA_COMPARE(ISAd[*v4] > ISAd[*v5])) { SWAP(v4, v5); }
+  if(SA_COMPARE(ISAd[*v2] > ISAd[*v4])) { SWAP(v2, v4); SWAP(v3, v5); }
+  if(SA_COMPARE(ISAd[*v1] > ISAd[*v3])) { SWAP(v1, v3); }
+  if(SA_COMPARE(ISAd[*v1] > ISAd[*v4])) { SWAP(v1, v4); SWAP(v3, v5); }
+  if(SA_COMPARE(ISAd[*v3] > ISAd[*v4])) { return v4; }
   return v3;
 }
 
@@ -195,6 +219,7 @@ struct _trbudget_t {
   saidx_t remain;
   saidx_t incval;
   saidx_t count;
+  saidx_t exhausted;
 };
 
 static INLINE
@@ -202,13 +227,14 @@ void
 trbudget_init(trbudget_t *budget, saidx_t chance, saidx_t incval) {
   budget->chance = chance;
   budget->remain = budget->incval = incval;
+  budget->exhausted = 0;
 }
 
 static INLINE
 saint_t
 trbudget_check(trbudget_t *budget, saidx_t size) {
   if(size <= budget->remain) { budget->remain -= size; return 1; }
-  if(budget->chance == 0) { budget->count += size; return 0; }
+  if(budget->chance == 0) { budget->count += size; budget->exhausted += 1; return 0; }
   budget->remain += budget->incval - size;
   budget->chance -= 1;
   return 1;
@@ -226,24 +252,24 @@ tr_partition(const saidx_t *ISAd,
   saidx_t t, s;
   saidx_t x = 0;
 
-  for(b = middle - 1; (++b < last) && ((x = ISAd[*b]) == v);) { }
+  for(b = middle - 1; (++b < last) && SA_COMPARE((x = ISAd[*b]) == v);) { }
   if(((a = b) < last) && (x < v)) {
-    for(; (++b < last) && ((x = ISAd[*b]) <= v);) {
+    for(; (++b < last) && SA_COMPARE((x = ISAd[*b]) <= v);) {
       if(x == v) { SWAP(*b, *a); ++a; }
     }
   }
-  for(c = last; (b < --c) && ((x = ISAd[*c]) == v);) { }
+  for(c = last; (b < --c) && SA_COMPARE((x = ISAd[*c]) == v);) { }
   if((b < (d = c)) && (x > v)) {
-    for(; (b < --c) && ((x = ISAd[*c]) >= v);) {
+    for(; (b < --c) && SA_COMPARE((x = ISAd[*c]) >= v);) {
       if(x == v) { SWAP(*c, *d); --d; }
     }
   }
   for(; b < c;) {
     SWAP(*b, *c);
-    for(; (++b < c) && ((x = ISAd[*b]) <= v);) {
+    for(; (++b < c) && SA_COMPARE((x = ISAd[*b]) <= v);) {
       if(x == v) { SWAP(*b, *a); ++a; }
     }
-    for(; (b < --c) && ((x = ISAd[*c]) >= v);) {
+    for(; (b < --c) && SA_COMPARE((x = ISAd[*c]) >= v);) {
       if(x == v) { SWAP(*c, *d); --d; }
     }
   }
@@ -271,13 +297,13 @@ tr_copy(saidx_t *ISA, const saidx_t *SA,
 
   v = b - SA - 1;
   for(c = first, d = a - 1; c <= d; ++c) {
-    if((0 <= (s = *c - depth)) && (ISA[s] == v)) {
+    if((0 <= (s = *c - depth)) && SA_COMPARE(ISA[s] == v)) {
       *++d = s;
       ISA[s] = d - SA;
     }
   }
   for(c = last - 1, e = d + 1, d = b; e < d; --c) {
-    if((0 <= (s = *c - depth)) && (ISA[s] == v)) {
+    if((0 <= (s = *c - depth)) && SA_COMPARE(ISA[s] == v)) {
       *--d = s;
       ISA[s] = d - SA;
     }
@@ -296,7 +322,7 @@ tr_partialcopy(saidx_t *ISA, const saidx_t *SA,
   v = b - SA - 1;
   lastrank = -1;
   for(c = first, d = a - 1; c <= d; ++c) {
-    if((0 <= (s = *c - depth)) && (ISA[s] == v)) {
+    if((0 <= (s = *c - depth)) && SA_COMPARE(ISA[s] == v)) {
       *++d = s;
       rank = ISA[s + depth];
       if(lastrank != rank) { lastrank = rank; newrank = d - SA; }
@@ -313,7 +339,7 @@ tr_partialcopy(saidx_t *ISA, const saidx_t *SA,
 
   lastrank = -1;
   for(c = last - 1, e = d + 1, d = b; e < d; --c) {
-    if((0 <= (s = *c - depth)) && (ISA[s] == v)) {
+    if((0 <= (s = *c - depth)) && SA_COMPARE(ISA[s] == v)) {
       *--d = s;
       rank = ISA[s + depth];
       if(lastrank != rank) { lastrank = rank; newrank = d - SA; }
@@ -326,7 +352,7 @@ static
 void
 tr_introsort(saidx_t *ISA, const saidx_t *ISAd,
              saidx_t *SA, saidx_t *first, saidx_t *last,
-             trbudget_t *budget) {
+             trbudget_t *budget, saidx_t threshold) {
 #define STACK_SIZE TR_STACKSIZE
   struct { const saidx_t *a; saidx_t *b, *c; saint_t d, e; }stack[STACK_SIZE];
   saidx_t *a, *b, *c;
@@ -426,8 +452,12 @@ tr_introsort(saidx_t *ISA, const saidx_t *ISAd,
       continue;
     }
 
-    if((last - first) <= TR_INSERTIONSORT_THRESHOLD) {
-      tr_insertionsort(ISAd, first, last);
+    if((last - first) <= threshold) {
+      if((last - first) <= SORTNET_SIZE) {
+        if(1 < (last - first)) { tr_leafsort(ISAd, first, last); }
+      } else {
+        tr_insertionsort(ISAd, first, last);
+      }
       limit = -3;
       continue;
     }
@@ -435,7 +465,7 @@ tr_introsort(saidx_t *ISA, const saidx_t *ISAd,
     if(limit-- == 0) {
       tr_heapsort(ISAd, first, last - first);
       for(a = last - 1; first < a; a = b) {
-        for(x = ISAd[*a], b = a - 1; (first <= b) && (ISAd[*b] == x); --b) { *b = ~*b; }
+        for(x = ISAd[*a], b = a - 1; (first <= b) && SA_COMPARE(ISAd[*b] == x); --b) { *b = ~*b; }
       }
       limit = -3;
       continue;
@@ -552,15 +582,22 @@ tr_introsort(saidx_t *ISA, const saidx_t *ISAd,
 
 /* Tandem repeat sort */
 void
-trsort(saidx_t *ISA, saidx_t *SA, saidx_t n, saidx_t depth) {
+trsort(saidx_t *ISA, saidx_t *SA, saidx_t n, saidx_t depth,
+       sactx_t *ctx) {
   saidx_t *ISAd;
   saidx_t *first, *last;
   trbudget_t budget;
-  saidx_t t, skip, unsorted;
+  double lo = ctx->lo, hi = ctx->hi;
+  saidx_t t, skip, unsorted, iterations = 0;
 
-  trbudget_init(&budget, tr_ilg(n) * 2 / 3, n);
-/*  trbudget_init(&budget, tr_ilg(n) * 3 / 4, n); */
+  trbudget_init(&budget, tr_ilg(n) * ctx->tuning->tr_budget_num / ctx->tuning->tr_budget_den, n);
   for(ISAd = ISA + depth; -n < *SA; ISAd += ISAd - ISA) {
+    ++iterations;
+    if(ctx->progress != NULL) {
+      /* Each pass takes half of what is left of the phase. */
+      progress_phase(ctx, lo, (lo + hi) / 2.0, n);
+      lo = (lo + hi) / 2.0;
+    }
     first = SA;
     skip = 0;
     unsorted = 0;
@@ -571,7 +608,8 @@ trsort(saidx_t *ISA, saidx_t *SA, saidx_t n, saidx_t depth) {
         last = SA + ISA[t] + 1;
         if(1 < (last - first)) {
           budget.count = 0;
-          tr_introsort(ISA, ISAd, SA, first, last, &budget);
+          tr_introsort(ISA, ISAd, SA, first, last,
+                       &budget, ctx->tuning->tr_insertionsort_threshold);
           if(budget.count != 0) { unsorted += budget.count; }
           else { skip = first - last; }
         } else if((last - first) == 1) {
@@ -579,8 +617,51 @@ trsort(saidx_t *ISA, saidx_t *SA, saidx_t n, saidx_t depth) {
         }
         first = last;
       }
+      if((ctx->progress != NULL) && (SA_PROGRESS_INTERVAL <= ((first - SA) - ctx->done)) &&
+         (progress_report(ctx, (first - SA) - ctx->done) != 0)) { break; }
     } while(first < (SA + n));
+    if(ctx->cancelled != 0) { break; }
     if(skip != 0) { *(first + skip) = skip; }
     if(unsorted == 0) { break; }
   }
+
+  if(ctx->stats != NULL) {
+    ctx->stats->tr_iterations += iterations;
+    ctx->stats->tr_budget_exhausted += budget.exhausted;
+  }
+}
+
+
+/*---------------------------------------------------------------------------*/
+
+/*- Test hooks -*/
+
+#if defined(SA_TEST_HOOKS)
+
+/* Sorts one group with the default budget, returning what was left unsorted. */
+saidx_t
+tr_test_introsort(saidx_t *ISA, const saidx_t *ISAd,
+                  saidx_t *SA, saidx_t *first, saidx_t *last,
+                  saidx_t threshold) {
+  trbudget_t budget;
+  trbudget_init(&budget, tr_ilg(last - first) * TR_BUDGET_NUM / TR_BUDGET_DEN, last - first);
+  budget.count = 0;
+  tr_introsort(ISA, ISAd, SA, first, last, &budget, threshold);
+  return budget.count;
+}
+
+void
+tr_test_partition(const saidx_t *ISAd,
+                  saidx_t *first, saidx_t *middle, saidx_t *last,
+                  saidx_t **pa, saidx_t **pb, saidx_t v) {
+  tr_partition(ISAd, first, middle, last, pa, pb, v);
+}
+
+void
+tr_test_copy(saidx_t *ISA, const saidx_t *SA,
+             saidx_t *first, saidx_t *a, saidx_t *b, saidx_t *last,
+             saidx_t depth) {
+  tr_copy(ISA, SA, first, a, b, last, depth);
 }
+
+#endif /* defined(SA_TEST_HOOKS) */
@@ -0,0 +1,126 @@
+/*
+ * tuning.c for libdivsufsort
+ * Copyright (c) 2003-2008 Yuta Mori All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "divsufsort_private.h"
+
+
+/* A profile is a text file of "name value" lines; blank lines and lines
+   starting with '#' are ignored. The names are those of the fields of
+   divsufsort_tuning_t. */
+
+/*- Private Functions -*/
+
+static
+saint_t *
+_field(divsufsort_tuning_t *tuning, const char *name) {
+  if(strcmp(name, "ss_blocksize") == 0) { return &tuning->ss_blocksize; }
+  if(strcmp(name, "ss_insertionsort_threshold") == 0) { return &tuning->ss_insertionsort_threshold; }
+  if(strcmp(name, "tr_insertionsort_threshold") == 0) { return &tuning->tr_insertionsort_threshold; }
+  if(strcmp(name, "tr_budget_num") == 0) { return &tuning->tr_budget_num; }
+  if(strcmp(name, "tr_budget_den") == 0) { return &tuning->tr_budget_den; }
+  return NULL;
+}
+
+/* Checks that the parameters are in range. */
+saint_t
+tuning_check(const divsufsort_tuning_t *tuning) {
+  return ((tuning->ss_blocksize < 0) || (SS_MAXBLOCKSIZE < tuning->ss_blocksize) ||
+          (tuning->ss_insertionsort_threshold < 1) ||
+          (TUNING_MAXTHRESHOLD < tuning->ss_insertionsort_threshold) ||
+          (tuning->tr_insertionsort_threshold < 1) ||
+          (TUNING_MAXTHRESHOLD < tuning->tr_insertionsort_threshold) ||
+          (tuning->tr_budget_num < 0) || (TUNING_MAXBUDGET < tuning->tr_budget_num) ||
+          (tuning->tr_budget_den < 1) || (TUNING_MAXBUDGET < tuning->tr_budget_den)) ? -1 : 0;
+}
+
+
+/*- Functions -*/
+
+void
+divsufsort_tuning_default(divsufsort_tuning_t *tuning) {
+  if(tuning == NULL) { return; }
+  tuning->ss_blocksize = SS_BLOCKSIZE;
+  tuning->ss_insertionsort_threshold = SS_INSERTIONSORT_THRESHOLD;
+  tuning->tr_insertionsort_threshold = TR_INSERTIONSORT_THRESHOLD;
+  tuning->tr_budget_num = TR_BUDGET_NUM;
+  tuning->tr_budget_den = TR_BUDGET_DEN;
+}
+
+saint_t
+divsufsort_tuning_load(const char *filename, divsufsort_tuning_t *tuning) {
+  FILE *fp;
+  char line[256], name[64], *p;
+  saint_t *field;
+  long value;
+  saint_t err = 0;
+
+  if((filename == NULL) || (tuning == NULL)) { return -1; }
+  if((fp = fopen(filename, "r")) == NULL) { return -1; }
+
+  divsufsort_tuning_default(tuning);
+  while((err == 0) && (fgets(line, sizeof(line), fp) != NULL)) {
+    for(p = line; (*p == ' ') || (*p == '\t'); ++p) { }
+    if((*p == '#') || (*p == '\n') || (*p == '\r') || (*p == '\0')) { continue; }
+    if((sscanf(p, "%63s %ld", name, &value) != 2) ||
+       ((field = _field(tuning, name)) == NULL) ||
+       (value < -0x7fffffffL) || (0x7fffffffL < value)) {
+      err = -3;
+    } else {
+      *field = (saint_t)value;
+    }
+  }
+  if((err == 0) && ferror(fp)) { err = -1; }
+  fclose(fp);
+  if((err == 0) && (tuning_check(tuning) != 0)) { err = -3; }
+  if(err != 0) { divsufsort_tuning_default(tuning); }
+
+  return err;
+}
+
+saint_t
+divsufsort_tuning_save(const char *filename, const divsufsort_tuning_t *tuning) {
+  FILE *fp;
+  saint_t err;
+
+  if((filename == NULL) || (tuning == NULL) || (tuning_check(tuning) != 0)) { return -1; }
+  if((fp = fopen(filename, "w")) == NULL) { return -1; }
+
+  err = (fprintf(fp,
+                 "# divsufsort tuning profile\n"
+                 "ss_blocksize %" PRIdSAINT_T "\n"
+                 "ss_insertionsort_threshold %" PRIdSAINT_T "\n"
+                 "tr_insertionsort_threshold %" PRIdSAINT_T "\n"
+                 "tr_budget_num %" PRIdSAINT_T "\n"
+                 "tr_budget_den %" PRIdSAINT_T "\n",
+                 tuning->ss_blocksize,
+                 tuning->ss_insertionsort_threshold,
+                 tuning->tr_insertionsort_threshold,
+                 tuning->tr_budget_num,
+                 tuning->tr_budget_den) < 0) ? -1 : 0;
+  if(fclose(fp) != 0) { err = -1; }
+
+  return err;
+}
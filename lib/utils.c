@@ -25,6 +25,9 @@
  */
 
 #include "divsufsort_private.h"
+#ifdef _OPENMP
+# include <omp.h>
+#endif
 
 
 /*- Private Function -*/
@@ -241,6 +244,80 @@ sufcheck(const sauchar_t *T, const saidx_t *SA,
 }
 
 
+/* Returns 1 if the suffix a of T[0..n-1] is smaller than the suffix b. */
+static INLINE
+saint_t
+_suffix_less(const sauchar_t *T, saidx_t n, saidx_t a, saidx_t b) {
+  saidx_t l = MIN(n - a, n - b), k = memlcp(T + a, T + b, l);
+  return (k < l) ? (T[a + k] < T[b + k]) : ((n - a) < (n - b));
+}
+
+/* Returns 1 if T[i..n-1] occurs more than once in T[0..n-1]. */
+static INLINE
+saint_t
+_suffix_repeats(const sauchar_t *T, saidx_t n, saidx_t i, const saidx_t *SA) {
+  return (i == n) || (1 < sa_search(T, n, T + i, n - i, SA, n, NULL));
+}
+
+/* Updates the suffix array of T[0..n-1] to that of T[0..N-1]. */
+saint_t
+sa_append(const sauchar_t *T, saidx_t *SA, saidx_t n, saidx_t N) {
+  saidx_t *B, *P;
+  saidx_t i, j, k, l, m, lo, hi, step;
+  saint_t err;
+
+  /* Check arguments. */
+  if((T == NULL) || (SA == NULL) || (n < 0) || (N < n)) { return -1; }
+  if(n == N) { return 0; }
+  if(n == 0) { return divsufsort(T, SA, N); }
+
+  /* Appending can reorder a suffix of the old text only if the whole of it
+     occurs earlier in the old text; those suffixes are T[l..n-1]. Find l by
+     galloping back from the end of the text. */
+  for(lo = n - 1, hi = n, step = 1;
+      (0 <= lo) && _suffix_repeats(T, n, lo, SA);
+      hi = lo, lo = n - (step <<= 1)) { }
+  for(lo = MAX(lo, -1); 1 < (hi - lo);) {
+    i = lo + (hi - lo) / 2;
+    if(_suffix_repeats(T, n, i, SA)) { hi = i; } else { lo = i; }
+  }
+  l = hi;
+
+  /* Sort the suffixes from l on, which are those of T[l..N-1]. */
+  m = N - l;
+  if((B = (saidx_t *)malloc((size_t)m * 2 * sizeof(saidx_t))) == NULL) { return -2; }
+  P = B + m;
+  if((err = divsufsort(T + l, B, m)) != 0) { free(B); return err; }
+  for(k = 0; k < m; ++k) { B[k] += l; }
+
+  /* Drop T[l..n-1] from the old suffix array; the rest keep their order. */
+  for(i = 0, j = 0; i < n; ++i) {
+    if(SA[i] < l) { SA[j++] = SA[i]; }
+  }
+
+  /* Rank each new suffix among the old ones. The ranks increase with k, so
+     each search gallops forward from the previous rank. */
+  for(k = 0, lo = 0; k < m; ++k) {
+    for(hi = lo, step = 1; (hi < j) && _suffix_less(T, N, SA[hi], B[k]);
+        lo = hi + 1, hi += step, step <<= 1) { }
+    for(hi = MIN(hi, j); lo < hi;) {
+      i = lo + (hi - lo) / 2;
+      if(_suffix_less(T, N, SA[i], B[k])) { lo = i + 1; } else { hi = i; }
+    }
+    P[k] = lo;
+  }
+
+  /* Merge from the right. */
+  for(k = m - 1, i = N; 0 <= k; --k) {
+    while(P[k] < j) { SA[--i] = SA[--j]; }
+    SA[--i] = B[k];
+  }
+
+  free(B);
+  return 0;
+}
+
+
 static
 int
 _compare(const sauchar_t *T, saidx_t Tsize,
@@ -248,31 +325,29 @@ _compare(const sauchar_t *T, saidx_t Tsize,
          saidx_t suf, saidx_t *match) {
   saidx_t i, j;
   saint_t r;
-  for(i = suf + *match, j = *match, r = 0;
-      (i < Tsize) && (j < Psize) && ((r = T[i] - P[j]) == 0); ++i, ++j) { }
+  i = suf + *match, j = *match;
+  j += memlcp(T + i, P + j, MIN(Tsize - i, Psize - j));
+  i = suf + j;
+  r = ((i < Tsize) && (j < Psize)) ? T[i] - P[j] : 0;
   *match = j;
   return (r == 0) ? -(j != Psize) : r;
 }
 
-/* Search for the pattern P in the string T. */
+/* Binary search for the pattern P in SA[0..SAsize-1], whose suffixes
+   all share their first match characters with P. */
+static
 saidx_t
-sa_search(const sauchar_t *T, saidx_t Tsize,
-          const sauchar_t *P, saidx_t Psize,
-          const saidx_t *SA, saidx_t SAsize,
-          saidx_t *idx) {
+_search_range(const sauchar_t *T, saidx_t Tsize,
+              const sauchar_t *P, saidx_t Psize,
+              const saidx_t *SA, saidx_t SAsize,
+              saidx_t match, saidx_t *idx) {
   saidx_t size, lsize, rsize, half;
-  saidx_t match, lmatch, rmatch;
+  saidx_t lmatch, rmatch;
   saidx_t llmatch, lrmatch, rlmatch, rrmatch;
   saidx_t i, j, k;
   saint_t r;
 
-  if(idx != NULL) { *idx = -1; }
-  if((T == NULL) || (P == NULL) || (SA == NULL) ||
-     (Tsize < 0) || (Psize < 0) || (SAsize < 0)) { return -1; }
-  if((Tsize == 0) || (SAsize == 0)) { return 0; }
-  if(Psize == 0) { if(idx != NULL) { *idx = 0; } return SAsize; }
-
-  for(i = j = k = 0, lmatch = rmatch = 0, size = SAsize, half = size >> 1;
+  for(i = j = k = 0, lmatch = rmatch = match, size = SAsize, half = size >> 1;
       0 < size;
       size = half, half >>= 1) {
     match = MIN(lmatch, rmatch);
@@ -324,6 +399,21 @@ sa_search(const sauchar_t *T, saidx_t Tsize,
   return k - j;
 }
 
+/* Search for the pattern P in the string T. */
+saidx_t
+sa_search(const sauchar_t *T, saidx_t Tsize,
+          const sauchar_t *P, saidx_t Psize,
+          const saidx_t *SA, saidx_t SAsize,
+          saidx_t *idx) {
+  if(idx != NULL) { *idx = -1; }
+  if((T == NULL) || (P == NULL) || (SA == NULL) ||
+     (Tsize < 0) || (Psize < 0) || (SAsize < 0)) { return -1; }
+  if((Tsize == 0) || (SAsize == 0)) { return 0; }
+  if(Psize == 0) { if(idx != NULL) { *idx = 0; } return SAsize; }
+
+  return _search_range(T, Tsize, P, Psize, SA, SAsize, 0, idx);
+}
+
 /* Search for the character c in the string T. */
 saidx_t
 sa_simplesearch(const sauchar_t *T, saidx_t Tsize,
@@ -379,3 +469,633 @@ sa_simplesearch(const sauchar_t *T, saidx_t Tsize,
   if(idx != NULL) { *idx = (0 < (k - j)) ? j : i; }
   return k - j;
 }
+
+
+/* A pattern of sa_search_batch. */
+typedef struct _sapattern_t sapattern_t;
+struct _sapattern_t {
+  const sauchar_t *P;
+  saidx_t Psize;
+  saidx_t k;
+};
+
+/* The state of a single search in sa_search_batch. */
+typedef struct _sabatch_t sabatch_t;
+struct _sabatch_t {
+  const sapattern_t *p;
+  saidx_t i, size;
+  saidx_t lmatch, rmatch;
+  saidx_t left, right, rrmatch, eq;
+  saidx_t suf;
+  saint_t upper;
+};
+
+static
+int
+_pattern_compare(const void *a, const void *b) {
+  const sapattern_t *p1 = (const sapattern_t *)a;
+  const sapattern_t *p2 = (const sapattern_t *)b;
+  saidx_t i, size;
+  for(i = 0, size = MIN(p1->Psize, p2->Psize); i < size; ++i) {
+    if(p1->P[i] != p2->P[i]) { return p1->P[i] - p2->P[i]; }
+  }
+  if(p1->Psize != p2->Psize) { return (p1->Psize < p2->Psize) ? -1 : 1; }
+  return (p1->k < p2->k) ? -1 : (p1->k > p2->k);
+}
+
+/* Searches a group of patterns in lockstep. Each search first finds the
+   lower bound of its pattern, then the upper bound within the part of the
+   range that the lower bound search has not already ruled out. */
+static
+void
+_search_group(const sauchar_t *T, saidx_t Tsize,
+              const saidx_t *SA, saidx_t SAsize,
+              const sapattern_t *first, const sapattern_t *last,
+              saidx_t *count, saidx_t *idx) {
+  sabatch_t state[SA_BATCH_GROUPSIZE];
+  sabatch_t *active[SA_BATCH_GROUPSIZE];
+  sabatch_t *b;
+  saidx_t half, match;
+  saint_t a, nactive, r;
+
+  for(nactive = 0; first < last; ++first) {
+    b = &state[nactive];
+    b->p = first;
+    b->i = 0, b->size = SAsize;
+    b->lmatch = b->rmatch = 0;
+    b->right = SAsize, b->rrmatch = 0, b->eq = -1;
+    b->upper = 0;
+    active[nactive++] = b;
+  }
+
+  while(0 < nactive) {
+    /* Prefetch the SA entries of the next probes. */
+    for(a = 0; a < nactive; ++a) {
+      b = active[a];
+      PREFETCH(SA + b->i + (b->size >> 1));
+    }
+    /* Load the suffixes and prefetch the text they point to. */
+    for(a = 0; a < nactive; ++a) {
+      b = active[a];
+      b->suf = SA[b->i + (b->size >> 1)];
+      PREFETCH(T + b->suf + MIN(b->lmatch, b->rmatch));
+    }
+    /* Compare and narrow each range. */
+    for(a = 0; a < nactive;) {
+      b = active[a];
+      half = b->size >> 1;
+      match = MIN(b->lmatch, b->rmatch);
+      r = _compare(T, Tsize, b->p->P, b->p->Psize, b->suf, &match);
+      if((r < 0) || ((r == 0) && (b->upper != 0))) {
+        b->i += half + 1;
+        b->size -= half + 1;
+        b->lmatch = match;
+      } else {
+        if(b->upper == 0) {
+          if(r > 0) { b->right = b->i + half, b->rrmatch = match; }
+          else if(b->eq < 0) { b->eq = b->i + half; }
+        }
+        b->size = half;
+        b->rmatch = match;
+      }
+      if((b->size == 0) && (b->upper == 0)) {
+        b->left = b->i;
+        if(0 <= b->eq) {
+          b->i = b->eq + 1, b->size = b->right - (b->eq + 1);
+          b->lmatch = b->p->Psize, b->rmatch = b->rrmatch;
+          b->upper = 1;
+        }
+      }
+      if(b->size == 0) {
+        count[b->p->k] = (b->upper != 0) ? b->i - b->left : 0;
+        if(idx != NULL) { idx[b->p->k] = b->left; }
+        active[a] = active[--nactive];
+      } else {
+        ++a;
+      }
+    }
+  }
+}
+
+/* Search for multiple patterns in the string T. */
+saint_t
+sa_search_batch(const sauchar_t *T, saidx_t Tsize,
+                const sauchar_t * const *P, const saidx_t *Psize,
+                saidx_t Pcount,
+                const saidx_t *SA, saidx_t SAsize,
+                saidx_t *count, saidx_t *idx, saint_t presort) {
+  sapattern_t buf[SA_BATCH_GROUPSIZE];
+  sapattern_t *patterns;
+  saidx_t i, j, k, m;
+
+  if((T == NULL) || (P == NULL) || (Psize == NULL) || (SA == NULL) ||
+     (count == NULL) || (Tsize < 0) || (SAsize < 0) || (Pcount < 0)) {
+    return -1;
+  }
+
+  /* Filter out the trivial patterns. */
+  patterns = NULL;
+  if(presort != 0) {
+    patterns = (sapattern_t *)malloc((size_t)MAX(Pcount, 1) * sizeof(sapattern_t));
+    if(patterns == NULL) { return -2; }
+  }
+  for(k = 0, m = 0; k < Pcount; ++k) {
+    if(idx != NULL) { idx[k] = -1; }
+    if((P[k] == NULL) || (Psize[k] < 0)) { count[k] = -1; }
+    else if((Tsize == 0) || (SAsize == 0)) { count[k] = 0; }
+    else if(Psize[k] == 0) {
+      count[k] = SAsize;
+      if(idx != NULL) { idx[k] = 0; }
+    } else if(patterns != NULL) {
+      patterns[m].P = P[k], patterns[m].Psize = Psize[k], patterns[m].k = k;
+      ++m;
+    }
+  }
+
+  if(patterns != NULL) {
+    /* Adjacent searches in sorted order share their upper probes,
+       which keeps those SA and T lines in cache. */
+    qsort(patterns, (size_t)m, sizeof(sapattern_t), _pattern_compare);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) default(shared) private(i)
+#endif
+    for(i = 0; i < m; i += SA_BATCH_GROUPSIZE) {
+      _search_group(T, Tsize, SA, SAsize,
+                    patterns + i, patterns + MIN(i + SA_BATCH_GROUPSIZE, m),
+                    count, idx);
+    }
+    free(patterns);
+  } else if((0 < Tsize) && (0 < SAsize)) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) default(shared) private(i, j, k, buf)
+#endif
+    for(i = 0; i < Pcount; i += SA_BATCH_GROUPSIZE) {
+      for(k = i, j = 0; (k < Pcount) && (k < (i + SA_BATCH_GROUPSIZE)); ++k) {
+        if((P[k] != NULL) && (0 < Psize[k])) {
+          buf[j].P = P[k], buf[j].Psize = Psize[k], buf[j].k = k;
+          ++j;
+        }
+      }
+      _search_group(T, Tsize, SA, SAsize, buf, buf + j, count, idx);
+    }
+  }
+
+  return 0;
+}
+
+
+/* Loads the first l bytes of U as a big-endian key. */
+static INLINE
+uint64_t
+_load_key(const sauchar_t *U, saidx_t l) {
+  uint64_t x;
+  saidx_t i;
+  for(i = 0, x = 0; i < l; ++i) { x = (x << 8) | U[i]; }
+  return x;
+}
+
+/* Builds the prefix cache of a suffix array. */
+saint_t
+sa_prefixcache(const sauchar_t *T, saidx_t Tsize,
+               const saidx_t *SA, saidx_t SAsize,
+               saidx_t step, sauchar_t *PC) {
+  saidx_t i, j, s;
+
+  if((T == NULL) || (SA == NULL) || (PC == NULL) ||
+     (Tsize < 0) || (SAsize < 0) || (step < 1)) { return -1; }
+
+  for(i = 0; i < SAsize; i += step, PC += SA_PREFIXCACHE_WIDTH) {
+    s = SA[i];
+    if((s < 0) || (Tsize <= s)) { return -1; }
+    for(j = 0; (j < SA_PREFIXCACHE_WIDTH) && (s + j < Tsize); ++j) { PC[j] = T[s + j]; }
+    for(; j < SA_PREFIXCACHE_WIDTH; ++j) { PC[j] = 0; }
+  }
+
+  return 0;
+}
+
+/* Search for the pattern P in the string T by using the prefix cache. */
+saidx_t
+sa_search_prefixcache(const sauchar_t *T, saidx_t Tsize,
+                      const sauchar_t *P, saidx_t Psize,
+                      const saidx_t *SA, saidx_t SAsize,
+                      const sauchar_t *PC, saidx_t step,
+                      saidx_t *idx) {
+  uint64_t key, x;
+  saidx_t size, half, i, j, k, l, m, lo, hi;
+  saint_t shift;
+
+  if(idx != NULL) { *idx = -1; }
+  if((T == NULL) || (P == NULL) || (SA == NULL) || (PC == NULL) ||
+     (Tsize < 0) || (Psize < 0) || (SAsize < 0) || (step < 1)) { return -1; }
+  if((Tsize == 0) || (SAsize == 0)) { return 0; }
+  if(Psize == 0) { if(idx != NULL) { *idx = 0; } return SAsize; }
+
+  /* Compare only the first l bytes; cached suffixes shorter than that are
+     zero-padded, which never makes them compare greater than P. */
+  l = MIN(Psize, SA_PREFIXCACHE_WIDTH);
+  shift = (saint_t)(SA_PREFIXCACHE_WIDTH - l) * 8;
+  key = _load_key(P, l);
+  m = (SAsize - 1) / step + 1;
+
+  /* The samples [j, k) share their first l bytes with P. */
+  for(i = 0, size = m; 0 < size;) {
+    half = size >> 1;
+    x = _load_key(PC + (i + half) * SA_PREFIXCACHE_WIDTH, SA_PREFIXCACHE_WIDTH) >> shift;
+    if(x < key) { i += half + 1, size -= half + 1; }
+    else { size = half; }
+  }
+  for(j = i, k = i, size = m - i; 0 < size;) {
+    half = size >> 1;
+    x = _load_key(PC + (k + half) * SA_PREFIXCACHE_WIDTH, SA_PREFIXCACHE_WIDTH) >> shift;
+    if(x <= key) { k += half + 1, size -= half + 1; }
+    else { size = half; }
+  }
+
+  if((step == 1) && (Psize <= SA_PREFIXCACHE_WIDTH) &&
+     (memchr(P, 0, (size_t)Psize) == NULL)) {
+    /* Every suffix is cached, and P cannot match the zero padding. */
+    if(idx != NULL) { *idx = j; }
+    return k - j;
+  }
+
+  /* Resolve the remaining boundaries by using T. */
+  lo = (j == 0) ? 0 : (j - 1) * step + 1;
+  hi = (k == m) ? SAsize : k * step;
+  if(lo < hi) {
+    size = sa_search(T, Tsize, P, Psize, SA + lo, hi - lo, &i);
+    if(idx != NULL) { *idx = lo + i; }
+    return size;
+  }
+  if(idx != NULL) { *idx = lo; }
+  return 0;
+}
+
+
+static INLINE
+void
+_locate_fixdown(saidx_t *H, saidx_t i, saidx_t size) {
+  saidx_t j, k, v;
+  for(v = H[i]; (j = 2 * i + 1) < size; H[i] = H[k], i = k) {
+    k = j++;
+    if((j < size) && (H[k] < H[j])) { k = j; }
+    if(H[k] <= v) { break; }
+  }
+  H[i] = v;
+}
+
+/* Selects the k smallest values of A[0..n-1] into a max-heap H[0..k-1]. */
+static
+saidx_t
+_locate_select(const saidx_t *A, saidx_t n, saidx_t *H, saidx_t k) {
+  saidx_t i;
+  if(n < k) { k = n; }
+  for(i = 0; i < k; ++i) { H[i] = A[i]; }
+  for(i = k / 2 - 1; 0 <= i; --i) { _locate_fixdown(H, i, k); }
+  for(i = k; i < n; ++i) {
+    if(A[i] < H[0]) { H[0] = A[i]; _locate_fixdown(H, 0, k); }
+  }
+  return k;
+}
+
+/* LSD radix sort of nonnegative values. The result is stored in A. */
+static
+void
+_locate_radixsort(saidx_t *A, saidx_t *B, saidx_t n, saidx_t maxval,
+                  saidx_t *hist, saint_t nthreads) {
+  saidx_t *S = A, *D = B, *t;
+  saidx_t i, sum;
+  saint_t shift, c;
+
+#ifndef _OPENMP
+  (void)nthreads;
+#endif
+  for(shift = 0;
+      (shift < (saint_t)(sizeof(saidx_t) * 8)) && (0 < (maxval >> shift));
+      shift += 8) {
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) default(shared) private(i, c)
+#endif
+    {
+      saidx_t *h, first, last;
+      saint_t tid = 0, nt = 1;
+#ifdef _OPENMP
+      tid = omp_get_thread_num(), nt = omp_get_num_threads();
+#endif
+      first = (saidx_t)(((double)n * tid) / nt);
+      last = (saidx_t)(((double)n * (tid + 1)) / nt);
+      h = hist + tid * ALPHABET_SIZE;
+      for(c = 0; c < ALPHABET_SIZE; ++c) { h[c] = 0; }
+      for(i = first; i < last; ++i) { ++h[(S[i] >> shift) & 0xff]; }
+#ifdef _OPENMP
+#pragma omp barrier
+#pragma omp single
+#endif
+      {
+        /* Bucket-major, thread-minor prefix sums keep the sort stable. */
+        for(c = 0, sum = 0; c < ALPHABET_SIZE; ++c) {
+          saint_t s;
+          for(s = 0; s < nt; ++s) {
+            saidx_t x = hist[s * ALPHABET_SIZE + c];
+            hist[s * ALPHABET_SIZE + c] = sum;
+            sum += x;
+          }
+        }
+      }
+      for(i = first; i < last; ++i) { D[h[(S[i] >> shift) & 0xff]++] = S[i]; }
+    }
+    t = S, S = D, D = t;
+  }
+  if(S != A) { memcpy(A, S, (size_t)n * sizeof(saidx_t)); }
+}
+
+/* Returns the positions SA[idx..idx+count-1] sorted by text position. */
+saidx_t
+sa_locate(const saidx_t *SA, saidx_t SAsize,
+          saidx_t idx, saidx_t count,
+          saidx_t *pos, saidx_t k, saint_t parallel) {
+  saidx_t *buf, *hist;
+  saidx_t i, maxval;
+  saint_t nthreads = 1;
+
+  if((SA == NULL) || (pos == NULL) || (SAsize < 0) || (idx < 0) ||
+     (count < 0) || (SAsize - idx < count) || (k < 0)) { return -1; }
+  SA += idx;
+  if(count < k) { k = count; }
+  if(k == 0) { return 0; }
+#ifdef _OPENMP
+  if((parallel != 0) && (SA_LOCATE_PARALLEL_THRESHOLD <= count)) {
+    nthreads = omp_get_max_threads();
+  }
+#else
+  (void)parallel;
+#endif
+
+  if(k < count) {
+    /* Top-k selection. */
+    if(nthreads == 1) {
+      _locate_select(SA, count, pos, k);
+    } else {
+      saidx_t *size;
+      buf = (saidx_t *)malloc((size_t)nthreads * k * sizeof(saidx_t));
+      size = (saidx_t *)malloc((size_t)nthreads * sizeof(saidx_t));
+      if((buf == NULL) || (size == NULL)) { free(size); free(buf); return -2; }
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads) default(shared)
+#endif
+      {
+        saint_t tid = 0, nt = 1;
+        saidx_t first, last;
+#ifdef _OPENMP
+        tid = omp_get_thread_num(), nt = omp_get_num_threads();
+#endif
+        first = (saidx_t)(((double)count * tid) / nt);
+        last = (saidx_t)(((double)count * (tid + 1)) / nt);
+        size[tid] = _locate_select(SA + first, last - first, buf + tid * k, k);
+#ifdef _OPENMP
+#pragma omp barrier
+#pragma omp single
+#endif
+        {
+          /* Compact the candidates of all threads. */
+          saint_t s;
+          for(s = 1, first = size[0]; s < nt; ++s) {
+            memmove(buf + first, buf + s * k, (size_t)size[s] * sizeof(saidx_t));
+            first += size[s];
+          }
+          _locate_select(buf, first, pos, k);
+        }
+      }
+      free(size);
+      free(buf);
+    }
+    /* Heapsort the selected positions. */
+    for(i = k - 1; 0 < i; --i) {
+      maxval = pos[0], pos[0] = pos[i], pos[i] = maxval;
+      _locate_fixdown(pos, 0, i);
+    }
+    return k;
+  }
+
+  /* Full radix sort. */
+  for(i = 0, maxval = 0; i < count; ++i) {
+    pos[i] = SA[i];
+    if(maxval < SA[i]) { maxval = SA[i]; }
+  }
+  if(count == 1) { return 1; }
+  buf = (saidx_t *)malloc((size_t)count * sizeof(saidx_t));
+  hist = (saidx_t *)malloc((size_t)nthreads * ALPHABET_SIZE * sizeof(saidx_t));
+  if((buf == NULL) || (hist == NULL)) { free(hist); free(buf); return -2; }
+  _locate_radixsort(pos, buf, count, maxval, hist, nthreads);
+  free(hist);
+  free(buf);
+
+  return count;
+}
+
+
+/* Builds the bucket index of the string T. */
+saint_t
+sa_bucketindex(const sauchar_t *T, saidx_t n, saidx_t *B, saint_t depth) {
+  saidx_t i, t, sum, size;
+
+  if((T == NULL) || (B == NULL) || (n < 0) || (depth < 1) || (2 < depth)) { return -1; }
+
+  size = SA_BUCKETINDEX_SIZE(depth);
+  for(i = 0; i < size; ++i) { B[i] = 0; }
+  if(depth == 1) {
+    for(i = 0; i < n; ++i) { ++B[T[i]]; }
+  } else if(0 < n) {
+    /* The last suffix is shorter than the others of its bucket,
+       so it is counted in slot 0, before every (c0, c1) slot. */
+    for(i = 0; i < (n - 1); ++i) { ++B[BUCKETINDEX2(T[i], T[i + 1])]; }
+    ++B[T[n - 1] * (ALPHABET_SIZE + 1)];
+  }
+  for(i = 0, sum = 0; i < size; ++i) { t = B[i]; B[i] = sum; sum += t; }
+
+  return 0;
+}
+
+/* Search for the pattern P in the string T by using the bucket index. */
+saidx_t
+sa_search_bucketindex(const sauchar_t *T, saidx_t Tsize,
+                      const sauchar_t *P, saidx_t Psize,
+                      const saidx_t *SA, saidx_t SAsize,
+                      const saidx_t *B, saint_t depth,
+                      saidx_t *idx) {
+  saidx_t lo, hi, size;
+
+  if(idx != NULL) { *idx = -1; }
+  if((T == NULL) || (P == NULL) || (SA == NULL) || (B == NULL) ||
+     (Tsize < 0) || (Psize < 0) || (SAsize != Tsize) ||
+     (depth < 1) || (2 < depth)) { return -1; }
+  if(Tsize == 0) { return 0; }
+  if(Psize == 0) { if(idx != NULL) { *idx = 0; } return SAsize; }
+
+  /* Look up the interval of the first one or two characters. */
+  if(depth == 1) {
+    lo = B[P[0]], hi = B[P[0] + 1];
+  } else if(Psize == 1) {
+    lo = B[P[0] * (ALPHABET_SIZE + 1)], hi = B[(P[0] + 1) * (ALPHABET_SIZE + 1)];
+  } else {
+    lo = B[BUCKETINDEX2(P[0], P[1])], hi = B[BUCKETINDEX2(P[0], P[1]) + 1];
+  }
+  if((Psize <= depth) || (hi <= lo)) {
+    if(idx != NULL) { *idx = lo; }
+    return hi - lo;
+  }
+
+  size = _search_range(T, Tsize, P, Psize, SA + lo, hi - lo, depth, idx);
+  if(idx != NULL) { *idx += lo; }
+  return size;
+}
+
+/* Search for the character c by using the bucket index. */
+saidx_t
+sa_simplesearch_bucketindex(const saidx_t *B, saint_t depth,
+                            saint_t c, saidx_t *idx) {
+  saidx_t lo, hi;
+
+  if(idx != NULL) { *idx = -1; }
+  if((B == NULL) || (depth < 1) || (2 < depth) ||
+     (c < 0) || (ALPHABET_SIZE <= c)) { return -1; }
+
+  if(depth == 1) {
+    lo = B[c], hi = B[c + 1];
+  } else {
+    lo = B[c * (ALPHABET_SIZE + 1)], hi = B[(c + 1) * (ALPHABET_SIZE + 1)];
+  }
+  if(idx != NULL) { *idx = lo; }
+  return hi - lo;
+}
+
+
+/* Binary search for a bound of the pattern P in SA[i..i+size-1], whose
+   left and right neighbours share lmatch and rmatch characters with P.
+   The lower bound is the first suffix not less than P; the upper bound
+   is the first suffix that is greater than P and does not start with P. */
+static
+saidx_t
+_search_bound(const sauchar_t *T, saidx_t Tsize,
+              const sauchar_t *P, saidx_t Psize,
+              const saidx_t *SA, saidx_t i, saidx_t size,
+              saidx_t lmatch, saidx_t rmatch, saint_t upper) {
+  saidx_t half, match;
+  saint_t r;
+
+  for(; 0 < size; size = half) {
+    half = size >> 1;
+    match = MIN(lmatch, rmatch);
+    r = _compare(T, Tsize, P, Psize, SA[i + half], &match);
+    if((r < 0) || ((r == 0) && (upper != 0))) {
+      i += half + 1;
+      half = size - half - 1;
+      lmatch = match;
+    } else {
+      rmatch = match;
+    }
+  }
+
+  return i;
+}
+
+/* Finds the lower bound of P1 and the upper bound of P2 in one descent,
+   which is shared until the two bounds fall on either side of a probe. */
+static
+saidx_t
+_search_range2(const sauchar_t *T, saidx_t Tsize,
+               const sauchar_t *P1, saidx_t P1size,
+               const sauchar_t *P2, saidx_t P2size,
+               const saidx_t *SA, saidx_t SAsize,
+               saidx_t *idx) {
+  saidx_t i, size, half, suf, lo, hi;
+  saidx_t lmatch1, rmatch1, lmatch2, rmatch2, match1, match2;
+  saint_t r1, r2;
+
+  for(i = 0, size = SAsize, lmatch1 = rmatch1 = lmatch2 = rmatch2 = 0;
+      0 < size;) {
+    half = size >> 1;
+    suf = SA[i + half];
+    match1 = MIN(lmatch1, rmatch1);
+    r1 = _compare(T, Tsize, P1, P1size, suf, &match1);
+    match2 = MIN(lmatch2, rmatch2);
+    r2 = _compare(T, Tsize, P2, P2size, suf, &match2);
+    if((r1 < 0) && (r2 <= 0)) {
+      i += half + 1;
+      size -= half + 1;
+      lmatch1 = match1, lmatch2 = match2;
+    } else if((0 <= r1) && (0 < r2)) {
+      size = half;
+      rmatch1 = match1, rmatch2 = match2;
+    } else if(0 <= r1) {
+      /* The probe lies in the range: P1 goes left and P2 goes right. */
+      lo = _search_bound(T, Tsize, P1, P1size, SA, i, half,
+                         lmatch1, match1, 0);
+      hi = _search_bound(T, Tsize, P2, P2size, SA, i + half + 1, size - half - 1,
+                         match2, rmatch2, 1);
+      *idx = lo;
+      return hi - lo;
+    } else {
+      /* P1 is greater than P2, so the range is empty. */
+      *idx = _search_bound(T, Tsize, P1, P1size, SA, i + half + 1, size - half - 1,
+                           match1, rmatch1, 0);
+      return 0;
+    }
+  }
+
+  *idx = i;
+  return 0;
+}
+
+/* Count the suffixes of the string T between the patterns P1 and P2. */
+saidx_t
+sa_range(const sauchar_t *T, saidx_t Tsize,
+         const sauchar_t *P1, saidx_t P1size,
+         const sauchar_t *P2, saidx_t P2size,
+         const saidx_t *SA, saidx_t SAsize,
+         saidx_t *idx) {
+  saidx_t i;
+
+  if(idx != NULL) { *idx = -1; }
+  if((T == NULL) || (P1 == NULL) || (P2 == NULL) || (SA == NULL) ||
+     (Tsize < 0) || (P1size < 0) || (P2size < 0) || (SAsize < 0)) { return -1; }
+  if((Tsize == 0) || (SAsize == 0)) { if(idx != NULL) { *idx = 0; } return 0; }
+
+  SAsize = _search_range2(T, Tsize, P1, P1size, P2, P2size, SA, SAsize, &i);
+  if(idx != NULL) { *idx = i; }
+  return SAsize;
+}
+
+/* Count the suffixes of the string T between multiple pairs of patterns. */
+saint_t
+sa_range_batch(const sauchar_t *T, saidx_t Tsize,
+               const sauchar_t * const *P1, const saidx_t *P1size,
+               const sauchar_t * const *P2, const saidx_t *P2size,
+               saidx_t Rcount,
+               const saidx_t *SA, saidx_t SAsize,
+               saidx_t *count, saidx_t *idx) {
+  saidx_t i, k;
+
+  if((T == NULL) || (P1 == NULL) || (P1size == NULL) ||
+     (P2 == NULL) || (P2size == NULL) || (SA == NULL) || (count == NULL) ||
+     (Tsize < 0) || (SAsize < 0) || (Rcount < 0)) {
+    return -1;
+  }
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, SA_BATCH_GROUPSIZE) default(shared) private(i, k)
+#endif
+  for(k = 0; k < Rcount; ++k) {
+    if((P1[k] == NULL) || (P1size[k] < 0) || (P2[k] == NULL) || (P2size[k] < 0)) {
+      count[k] = -1, i = -1;
+    } else if((Tsize == 0) || (SAsize == 0)) {
+      count[k] = 0, i = 0;
+    } else {
+      count[k] = _search_range2(T, Tsize, P1[k], P1size[k], P2[k], P2size[k],
+                                SA, SAsize, &i);
+    }
+    if(idx != NULL) { idx[k] = i; }
+  }
+
+  return 0;
+}